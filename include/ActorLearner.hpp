@@ -0,0 +1,27 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "Agent.hpp"
+#include "MPSCQueue.hpp"
+
+// actor threads simulate episodes in their own cpu tunnel environment with a snapshot of the policy
+// while the learner optimizes the agent with the finished trajectories
+class ActorLearner
+{
+public:
+    ActorLearner(const std::string& nn_file = "", uint32_t episode_count = 1000, uint32_t actor_count = 4);
+    void run();
+
+private:
+    Agent agent;
+    MPSCQueue<Trajectory> trajectory_queue;
+    std::atomic<uint32_t> started_episode_count;
+    std::atomic<bool> stop;
+    uint32_t episode_count;
+    uint32_t actor_count;
+
+    void act(uint32_t actor_idx);
+};
@@ -1,16 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
 #include <random>
 #include <torch/optim/adam.h>
+#include <torch/utils.h>
 
 #include "NeuralNet.hpp"
 #include "MoveActions.hpp"
+#include "MPSCQueue.hpp"
+#include "PolicyKernel.hpp"
+
+// preallocated storage for the episodes of env_count environments that are simulated in lockstep
+// only raw data is stored, the log probabilities are recomputed when optimizing
+struct RolloutBuffer
+{
+    RolloutBuffer(uint32_t capacity = 0, uint32_t env_count = 0);
+    void clear();
+
+    uint32_t capacity;
+    uint32_t env_count;
+    uint32_t step_count = 0;
+    // [capacity, env_count, 8]
+    std::vector<float> states;
+    // [capacity, env_count]
+    std::vector<int64_t> action_indices;
+    // [capacity, env_count]
+    std::vector<float> rewards;
+    // number of steps every environment was active for
+    std::vector<uint32_t> episode_lengths;
+};
+
+// one episode collected by an actor with a snapshot of the policy
+struct Trajectory
+{
+    // row major [step count, 8]
+    std::vector<float> states;
+    std::vector<int64_t> action_indices;
+    std::vector<float> rewards;
+    float distance = 0.0f;
+};
 
 class Agent
 {
 public:
     Agent(bool train_mode);
     MoveActionFlags::type get_action(const std::vector<float>& state);
+    // sample with the policy kernel and the given generator; can be called from multiple threads as it does not modify the agent
+    MoveActionFlags::type get_action(const std::vector<float>& state, std::mt19937& generator) const;
     void add_reward_for_last_action(float reward);
     void optimize();
+    // sample one action per row of the [N, 8] states with a single forward pass
+    std::vector<MoveActionFlags::type> get_actions(const torch::Tensor& states);
+    // rewards of the last batch of actions; entries of environments that are not active anymore are ignored
+    void add_rewards_for_last_actions(const std::vector<float>& step_rewards, const std::vector<uint8_t>& active);
+    // optimize with the episodes of all environments of the batch in one step
+    void optimize_batch();
+    // learner side of the actor-learner training; recomputes the log probabilities of the trajectory with the current network
+    void optimize(const Trajectory& trajectory);
+    // consume trajectories until episode_count episodes were optimized and publish new weights every publish_interval episodes
+    void learn(MPSCQueue<Trajectory>& queue, uint32_t episode_count, uint32_t publish_interval);
+    void publish_policy();
+    // read-only copy of the network that actors use to sample actions
+    std::shared_ptr<NeuralNet> get_policy_snapshot() const;
+    static uint32_t sample_action_index(NeuralNet& policy, const std::vector<float>& state, std::mt19937& gen);
+    static MoveActionFlags::type index_to_action_mask(uint32_t idx);
     bool is_training();
     void save_to_file(const std::string& filename);
     void load_from_file(const std::string& filename);
@@ -19,13 +73,14 @@ private:
     std::shared_ptr<NeuralNet> nn;
     std::unique_ptr<torch::optim::Adam> optimizer;
     std::mt19937 gen;
-    std::vector<MoveActionFlags::type> actions;
-    std::vector<torch::Tensor> action_log_probs;
-    std::vector<torch::Tensor> action_tensors;
-    std::vector<float> rewards;
+    RolloutBuffer rollout;
+    // evaluates the network without libtorch when the agent is only playing
+    PolicyKernel policy_kernel;
+    std::atomic<std::shared_ptr<NeuralNet>> policy_snapshot;
     bool train_mode;
 
-    MoveActionFlags::type index_to_action_mask(uint32_t idx);
-    void clear_buffers();
+    void update_policy_kernel();
+    void prepare_rollout(uint32_t env_count);
+    void optimize_rollout(const float* states, const int64_t* action_indices, const float* rewards, const std::vector<uint32_t>& episode_lengths, uint32_t step_count, uint32_t env_count);
 };
 
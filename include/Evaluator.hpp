@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Agent.hpp"
+
+// plays seeded episodes with a checkpoint in cpu tunnel environments on multiple threads and writes statistics as json
+class Evaluator
+{
+public:
+    // thread_count 0 uses all hardware threads
+    Evaluator(const std::string& nn_file, uint32_t episode_count = 100, uint32_t thread_count = 0, uint32_t seed = 0, uint32_t max_steps = 3600);
+    void run(const std::string& report_file);
+
+private:
+    struct EpisodeResult
+    {
+        uint32_t seed = 0;
+        float distance = 0.0f;
+        uint32_t lifes_lost = 0;
+        uint32_t steps = 0;
+    };
+
+    std::string nn_file;
+    Agent agent;
+    std::vector<EpisodeResult> results;
+    uint32_t thread_count;
+    uint32_t seed;
+    uint32_t max_steps;
+
+    void evaluate_episodes(std::atomic<uint32_t>& next_episode);
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Agent.hpp"
+#include "PPOAgent.hpp"
+#include "VecEnv.hpp"
+
+// trains the agent in cpu only tunnel environments; no window or vulkan context is created
+class HeadlessContext
+{
+public:
+    HeadlessContext(const std::string& nn_file = "", uint32_t episode_count = 1000, uint32_t env_count = 1, bool use_ppo = false);
+    void run();
+
+private:
+    ve::VecEnv envs;
+    Agent agent;
+    // only created if the agent is trained with ppo instead of reinforce
+    std::unique_ptr<PPOAgent> ppo_agent;
+    uint32_t episode_count;
+
+    void run_ppo();
+};
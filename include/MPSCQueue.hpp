@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// bounded lock-free queue for multiple producers and a single consumer (based on Vyukov's bounded MPMC queue)
+// every cell carries a sequence number that tells producers and the consumer whose turn it is to access the cell
+template<class T>
+class MPSCQueue
+{
+public:
+    MPSCQueue(uint32_t size) : cells(std::make_unique<Cell[]>(size)), mask(size - 1), enqueue_pos(0), dequeue_pos(0), push_count(0), pop_count(0), closed(false)
+    {
+        // size must be power of 2
+        assert((size & (size - 1)) == 0);
+        for (uint32_t i = 0; i < size; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // returns false if the queue is full
+    bool try_push(T&& element)
+    {
+        Cell* cell;
+        uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &cells[pos & mask];
+            const int64_t diff = int64_t(cell->sequence.load(std::memory_order_acquire)) - int64_t(pos);
+            if (diff == 0)
+            {
+                // cell is free, try to claim it
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0)
+            {
+                // consumer did not free the cell yet
+                return false;
+            }
+            else
+            {
+                // another producer claimed the cell
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->element = std::move(element);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        // wake up the consumer if it is blocked in pop
+        push_count.fetch_add(1);
+        push_count.notify_one();
+        return true;
+    }
+
+    // spins shortly and then blocks while the queue is full; returns false if the queue got closed
+    bool push(T&& element)
+    {
+        for (uint32_t i = 0;; ++i)
+        {
+            const uint32_t observed_pop_count = pop_count.load();
+            if (closed.load()) return false;
+            if (try_push(std::move(element))) return true;
+            // a pop after loading the count changes it, so the wait does not miss it
+            i < spin_count ? std::this_thread::yield() : pop_count.wait(observed_pop_count);
+        }
+    }
+
+    // returns false if the queue is empty; must only be called from one thread
+    bool try_pop(T& element)
+    {
+        Cell& cell = cells[dequeue_pos & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeue_pos + 1) return false;
+        element = std::move(cell.element);
+        cell.sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+        dequeue_pos++;
+        // wake up producers that are blocked in push
+        pop_count.fetch_add(1);
+        pop_count.notify_all();
+        return true;
+    }
+
+    // spins shortly and then blocks while the queue is empty; returns false if the queue got closed and is empty
+    bool pop(T& element)
+    {
+        for (uint32_t i = 0;; ++i)
+        {
+            const uint32_t observed_push_count = push_count.load();
+            if (try_pop(element)) return true;
+            if (closed.load()) return false;
+            i < spin_count ? std::this_thread::yield() : push_count.wait(observed_push_count);
+        }
+    }
+
+    // wakes up all blocked threads and lets further calls of push fail
+    void close()
+    {
+        closed.store(true);
+        push_count.fetch_add(1);
+        push_count.notify_all();
+        pop_count.fetch_add(1);
+        pop_count.notify_all();
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint64_t> sequence;
+        T element;
+    };
+
+    // number of failed attempts before a blocking call waits instead of yielding
+    static constexpr uint32_t spin_count = 64;
+
+    std::unique_ptr<Cell[]> cells;
+    const uint64_t mask;
+    // keep producer and consumer positions on separate cache lines
+    alignas(64) std::atomic<uint64_t> enqueue_pos;
+    alignas(64) uint64_t dequeue_pos;
+    // only used to block and wake up threads when the queue is full or empty
+    alignas(64) std::atomic<uint32_t> push_count;
+    alignas(64) std::atomic<uint32_t> pop_count;
+    std::atomic<bool> closed;
+};
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <optional>
 
 #include "EventHandler.hpp"
@@ -10,11 +12,13 @@
 #include "Agent.hpp"
 #include "MoveActions.hpp"
 #include "Camera.hpp"
+#include "Replay.hpp"
 
 class MainContext
 {
 public:
-    MainContext(const std::string& nn_file = "", bool train_mode = false, bool disable_rendering = false);
+    // record_file: write the input of every frame to this file; replay_file: play back the input of a recording instead of reading the keyboard
+    MainContext(const std::string& nn_file = "", bool train_mode = false, bool disable_rendering = false, uint32_t seed = 0, const std::string& record_file = "", const std::string& replay_file = "");
     ~MainContext();
     void run();
 
@@ -31,7 +35,16 @@ private:
     Agent agent;
     bool use_agent = false;
     bool game_mode = true;
+    // every restart generates the tunnel from seed + restart_count; restarts of a replay use the recorded seed
+    uint32_t seed;
+    uint32_t restart_count = 0;
+    std::string record_file;
+    std::optional<Replay> replay;
+    bool is_replaying = false;
 
-    void restart();
-    void dispatch_pressed_keys(EventHandler& eh, const MoveActionFlags::type action = MoveActionFlags::NoMove);
+    uint32_t next_tunnel_seed();
+    void restart(uint32_t tunnel_seed);
+    // returns the combined move actions of the agent and the pressed keys
+    // while recording, the input that is not part of the move actions is written to replay_frame; during playback it is read from it
+    MoveActionFlags::type dispatch_pressed_keys(EventHandler& eh, ReplayFrame& replay_frame, const MoveActionFlags::type action = MoveActionFlags::NoMove);
 };
@@ -1,10 +1,20 @@
+#pragma once
+
 #include <torch/nn/modules/linear.h>
+#include <utility>
 
 class NeuralNet : public torch::nn::Module
 {
 public:
-    NeuralNet();
+    // collision distances, velocity and rotation speed
+    static constexpr uint32_t input_size = 8;
+    static constexpr uint32_t output_size = 11;
+
+    // the value head is only needed by PPOAgent; checkpoints without it can still be loaded into a network without value head
+    NeuralNet(bool value_head = false);
     torch::Tensor forward(torch::Tensor x);
+    // log action probabilities and the value of the states
+    std::pair<torch::Tensor, torch::Tensor> forward_with_value(torch::Tensor x);
 private:
     torch::nn::Linear fc0 = nullptr;
     torch::nn::Linear fc1 = nullptr;
@@ -12,5 +22,8 @@ private:
     torch::nn::Linear fc3 = nullptr;
     torch::nn::Linear fc4 = nullptr;
     torch::nn::Linear fc5 = nullptr;
+    torch::nn::Linear fc_value = nullptr;
+
+    torch::Tensor hidden(torch::Tensor x);
 };
 
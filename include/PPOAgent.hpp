@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <random>
+#include <torch/optim/adam.h>
+#include <torch/utils.h>
+
+#include "NeuralNet.hpp"
+#include "MoveActions.hpp"
+
+// fixed size rollout of env_count environments that are simulated in lockstep and reset as soon as they are done
+struct PPORollout
+{
+    PPORollout(uint32_t horizon, uint32_t env_count);
+
+    uint32_t horizon;
+    uint32_t env_count;
+    uint32_t step_count = 0;
+    // [horizon, env_count, 8]
+    std::vector<float> states;
+    // [horizon, env_count]
+    std::vector<int64_t> action_indices;
+    std::vector<float> log_probs;
+    std::vector<float> values;
+    std::vector<float> rewards;
+    std::vector<uint8_t> dones;
+    std::vector<uint8_t> truncated;
+    // value of the final state of episodes that were truncated by the step limit
+    std::vector<float> bootstrap_values;
+};
+
+// proximal policy optimization with a value head, generalized advantage estimation and multiple epochs of minibatch updates per rollout
+class PPOAgent
+{
+public:
+    PPOAgent(uint32_t env_count, uint32_t horizon = 256);
+    // sample one action per row of the [N, 8] states and store the data needed for the update
+    std::vector<MoveActionFlags::type> get_actions(const torch::Tensor& states);
+    // environments that are done must be reset before the next call of get_actions
+    // final_states are the [N, 8] states after the step and before the reset, truncated episodes bootstrap from their value
+    void add_rewards_for_last_actions(const std::vector<float>& step_rewards, const std::vector<uint8_t>& dones, const std::vector<uint8_t>& truncated, const torch::Tensor& final_states);
+    bool is_rollout_full() const;
+    // next_states are the [N, 8] states after the last step of the rollout, their values bootstrap the unfinished episodes
+    void optimize(const torch::Tensor& next_states);
+    void save_to_file(const std::string& filename);
+    // also accepts checkpoints of Agent that have no value head, the value head keeps its initial weights then
+    void load_from_file(const std::string& filename);
+
+private:
+    std::shared_ptr<NeuralNet> nn;
+    std::unique_ptr<torch::optim::Adam> optimizer;
+    std::mt19937 gen;
+    PPORollout rollout;
+
+    void compute_advantages(const torch::Tensor& next_values, std::vector<float>& advantages, std::vector<float>& returns) const;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+// inference only evaluation of the policy network (same architecture as NeuralNet) without libtorch
+// weights are stored transposed and padded in aligned arrays such that every layer is a sequence of broadcasted fused multiply-adds
+class PolicyKernel
+{
+public:
+    static constexpr uint32_t input_size = 8;
+    static constexpr uint32_t hidden_size = 32;
+    static constexpr uint32_t output_size = 11;
+    // output is padded to a multiple of the simd width
+    static constexpr uint32_t padded_output_size = 16;
+    static constexpr uint32_t layer_count = 6;
+
+    enum class Isa
+    {
+        Scalar = 0,
+        AVX2 = 1,
+        NEON = 2
+    };
+
+    // uses the best instruction set that is supported by the build and the cpu
+    PolicyKernel();
+    // weights are row major [out, in] like the ones of torch::nn::Linear
+    void set_layer(uint32_t layer_idx, const float* weights, const float* bias);
+    // writes output_size action probabilities
+    void forward(const float* state, float* probs) const;
+    static bool is_supported(Isa isa);
+    // returns false and keeps the current instruction set if the given one is not supported
+    bool set_isa(Isa isa);
+    const char* get_isa_name() const;
+
+private:
+    alignas(32) float w0[input_size * hidden_size] = {};
+    alignas(32) float w_hidden[layer_count - 2][hidden_size * hidden_size] = {};
+    alignas(32) float w_out[hidden_size * padded_output_size] = {};
+    alignas(32) float b_hidden[layer_count - 1][hidden_size] = {};
+    alignas(32) float b_out[padded_output_size] = {};
+    Isa isa;
+};
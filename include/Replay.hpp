@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/vec2.hpp>
+
+#include "MoveActions.hpp"
+
+// input of one frame; together with the tunnel seed this is everything needed to reproduce a run
+struct ReplayFrame
+{
+    // settings are stored as state instead of key presses such that changes from the ui are recorded as well
+    enum Flags : uint32_t
+    {
+        GameMode = 0x1,
+        CollisionDetection = 0x2,
+        TrackingCamera = 0x4,
+        // camera was rotated with the mouse
+        MouseLook = 0x8,
+        Restart = 0x10,
+        IncreaseFreeFlightSpeed = 0x20,
+        ReduceFreeFlightSpeed = 0x40
+    };
+
+    MoveActionFlags::type actions = MoveActionFlags::NoMove;
+    uint32_t flags = 0;
+    // seed of the new tunnel if the frame contains a restart
+    uint32_t restart_seed = 0;
+    glm::vec2 mouse_motion = glm::vec2(0.0f);
+    // time difference used by the following frame
+    float time_diff = 0.0f;
+};
+
+// compact binary recording of the per frame input
+// layout: "VERP", version, seed, frame count (all uint32_t) followed by frame count times (actions, flags, restart_seed, mouse_motion.x, mouse_motion.y, time_diff)
+class Replay
+{
+public:
+    Replay(uint32_t seed = 0);
+    void add_frame(const ReplayFrame& frame);
+    bool is_finished() const;
+    // frames are played back in the order they were recorded
+    const ReplayFrame& next_frame();
+    uint32_t get_seed() const;
+    uint32_t get_frame_count() const;
+    void save_to_file(const std::string& filename) const;
+    void load_from_file(const std::string& filename);
+
+private:
+    static constexpr uint32_t version = 2;
+
+    uint32_t seed;
+    std::vector<ReplayFrame> frames;
+    uint32_t playback_idx = 0;
+};
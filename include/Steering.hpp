@@ -1,3 +1,5 @@
+#pragma once
+
 #include <utility>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
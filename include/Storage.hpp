@@ -1,5 +1,6 @@
 #pragma once
 
+#include <limits>
 #include <vector>
 #include <unordered_map>
 #include "vk/Buffer.hpp"
@@ -7,92 +8,136 @@
 
 namespace ve
 {
+    // slot of a resource in the storage and the generation of the slot when the resource was added
+    // the generation is increased when the resource is destroyed, so a handle to a destroyed resource is detected even if the slot is reused
+    template<typename T>
+    struct StorageHandle
+    {
+        static constexpr uint32_t invalid_idx = std::numeric_limits<uint32_t>::max();
+
+        uint32_t idx = invalid_idx;
+        uint32_t generation = 0;
+
+        bool is_valid() const
+        {
+            return idx != invalid_idx;
+        }
+
+        bool operator==(const StorageHandle& other) const = default;
+    };
+
+    using BufferHandle = StorageHandle<Buffer>;
+    using ImageHandle = StorageHandle<Image>;
+
     class Storage
     {
     public:
         Storage(const VulkanMainContext& vmc, VulkanCommandContext& vcc);
 
         template<typename... Args>
-        uint32_t add_named_buffer(const std::string& name, Args&&... args)
+        BufferHandle add_named_buffer(const std::string& name, Args&&... args)
         {
-            buffers.emplace_back(std::make_optional<Buffer>(vmc, vcc, std::forward<Args>(args)...));
-            if (buffer_names.contains(name))
-            {
-                if (buffers.at(buffer_names.at(name)).has_value())
-                {
-                    // buffer name is already taken by an existing buffer
-                    spdlog::warn("Duplicate buffer name!");
-                }
-                else
-                {
-                    // buffer name exists but the corresponding buffer got deleted; so, reuse the name
-                    buffer_names.at(name) = buffers.size() - 1;
-                }
-            }
-            else
-            {
-                buffer_names.emplace(name, buffers.size() - 1);
-            }
-            const vk::Buffer& b = buffers.back().value().get();
+            BufferHandle handle = add_resource(buffers, free_buffer_slots, std::forward<Args>(args)...);
+            add_name(buffer_names, buffers, name, handle);
+            const vk::Buffer& b = get_buffer(handle).get();
             vk::DebugUtilsObjectNameInfoEXT dmoni(b.objectType, uint64_t(static_cast<vk::Buffer::CType>(b)), name.c_str());
             vmc.logical_device.get().setDebugUtilsObjectNameEXT(dmoni);
-            return buffers.size() - 1;
+            return handle;
         }
 
         template<typename... Args>
-        uint32_t add_named_image(const std::string& name, Args&&... args)
+        ImageHandle add_named_image(const std::string& name, Args&&... args)
         {
-            images.emplace_back(std::make_optional<Image>(vmc, vcc, std::forward<Args>(args)...));
-            if (image_names.contains(name))
-            {
-                if (images.at(image_names.at(name)).has_value())
-                {
-                    // image name is already taken by an existing image
-                    spdlog::warn("Duplicate image name!");
-                }
-                else
-                {
-                    // image name exists but the corresponding image got deleted; so, reuse the name
-                    image_names.at(name) = images.size() - 1;
-                }
-            }
-            else
-            {
-                image_names.emplace(name, images.size() - 1);
-            }
-            return images.size() - 1;
+            ImageHandle handle = add_resource(images, free_image_slots, std::forward<Args>(args)...);
+            add_name(image_names, images, name, handle);
+            return handle;
         }
 
         template<typename... Args>
-        uint32_t add_buffer(Args&&... args)
+        BufferHandle add_buffer(Args&&... args)
         {
-            buffers.emplace_back(std::make_optional<Buffer>(vmc, vcc, std::forward<Args>(args)...));
-            return buffers.size() - 1;
+            return add_resource(buffers, free_buffer_slots, std::forward<Args>(args)...);
         }
 
         template<typename... Args>
-        uint32_t add_image(Args&&... args)
+        ImageHandle add_image(Args&&... args)
         {
-            images.emplace_back(std::make_optional<Image>(vmc, vcc, std::forward<Args>(args)...));
-            return images.size() - 1;
+            return add_resource(images, free_image_slots, std::forward<Args>(args)...);
         }
 
-        void destroy_buffer(uint32_t idx);
-        void destroy_image(uint32_t idx);
+        void destroy_buffer(BufferHandle handle);
+        void destroy_image(ImageHandle handle);
         void destroy_buffer(const std::string& name);
         void destroy_image(const std::string& name);
         void clear();
-        Buffer& get_buffer(uint32_t idx);
-        Image& get_image(uint32_t idx);
+        Buffer& get_buffer(BufferHandle handle);
+        Image& get_image(ImageHandle handle);
+        // name lookups hash the name, so they are meant for setting up descriptors and debugging and not for every frame
         Buffer& get_buffer_by_name(const std::string& name);
         Image& get_image_by_name(const std::string& name);
 
     private:
+        template<typename T>
+        struct Slot
+        {
+            std::optional<T> resource;
+            uint32_t generation = 0;
+        };
+
+        template<typename T, typename... Args>
+        StorageHandle<T> add_resource(std::vector<Slot<T>>& slots, std::vector<uint32_t>& free_slots, Args&&... args)
+        {
+            // reuse the slot of a destroyed resource if there is one
+            uint32_t idx = slots.size();
+            if (!free_slots.empty())
+            {
+                idx = free_slots.back();
+                free_slots.pop_back();
+            }
+            else
+            {
+                slots.emplace_back();
+            }
+            slots[idx].resource.emplace(vmc, vcc, std::forward<Args>(args)...);
+            return StorageHandle<T>{idx, slots[idx].generation};
+        }
+
+        template<typename T>
+        void add_name(std::unordered_map<std::string, StorageHandle<T>>& names, const std::vector<Slot<T>>& slots, const std::string& name, StorageHandle<T> handle)
+        {
+            auto it = names.find(name);
+            if (it == names.end())
+            {
+                names.emplace(name, handle);
+            }
+            else if (is_alive(slots, it->second))
+            {
+                // name is already taken by an existing resource
+                spdlog::warn("Duplicate storage name \"{}\"!", name);
+            }
+            else
+            {
+                // name exists but the corresponding resource got destroyed; so, reuse the name
+                it->second = handle;
+            }
+        }
+
+        template<typename T>
+        static bool is_alive(const std::vector<Slot<T>>& slots, StorageHandle<T> handle)
+        {
+            return handle.idx < slots.size() && slots[handle.idx].generation == handle.generation && slots[handle.idx].resource.has_value();
+        }
+
+        template<typename T>
+        static void destroy_resource(std::vector<Slot<T>>& slots, std::vector<uint32_t>& free_slots, uint32_t idx);
+
         const VulkanMainContext& vmc;
         VulkanCommandContext& vcc;
-        std::vector<std::optional<Buffer>> buffers;
-        std::vector<std::optional<Image>> images;
-        std::unordered_map<std::string, uint32_t> buffer_names;
-        std::unordered_map<std::string, uint32_t> image_names;
+        std::vector<Slot<Buffer>> buffers;
+        std::vector<Slot<Image>> images;
+        std::vector<uint32_t> free_buffer_slots;
+        std::vector<uint32_t> free_image_slots;
+        std::unordered_map<std::string, BufferHandle> buffer_names;
+        std::unordered_map<std::string, ImageHandle> image_names;
     };
 } // namespace ve
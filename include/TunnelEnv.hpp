@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/vec3.hpp>
+
+#include "Camera.hpp"
+#include "MoveActions.hpp"
+#include "Steering.hpp"
+#include "vk/TunnelBezierPoints.hpp"
+#include "vk/common.hpp"
+
+namespace ve
+{
+    // cpu only version of the game loop that is used to train the agent without a gpu
+    // the walls are evaluated analytically from the Bézier curves and the tunnel noise instead of the generated mesh
+    class TunnelEnv
+    {
+    public:
+        // collision distances followed by velocity and rotation speed (same layout as assembled in MainContext::run)
+        static constexpr uint32_t state_size = distance_directions_count + 3;
+
+        // with more than one life the player is reset into the tunnel after a collision like in the game instead of ending the episode
+        TunnelEnv(uint32_t seed = 0, float time_diff = 0.016667f, uint32_t max_steps = 1200, uint32_t max_player_lifes = 1);
+        const std::vector<float>& reset();
+        const std::vector<float>& step(MoveActionFlags::type action);
+        const std::vector<float>& get_state() const;
+        float get_reward() const;
+        bool is_done() const;
+        // episode was cut off by the step limit while the player was still alive
+        bool is_truncated() const;
+        float get_distance() const;
+        uint32_t get_step_count() const;
+        uint32_t get_lifes_lost() const;
+
+    private:
+        struct WallSample
+        {
+            uint32_t segment_id;
+            float t;
+            // distance from the sampled position to the wall; negative if the position is outside of the tunnel
+            float clearance;
+            bool outside_of_tunnel;
+        };
+
+        TunnelBezierPoints tunnel_bezier_points;
+        Steering::Simulation simulation_steering;
+        Camera camera;
+        std::vector<float> state;
+        float time_diff;
+        uint32_t max_steps;
+        uint32_t max_player_lifes;
+        uint32_t player_lifes;
+        uint32_t step_count = 0;
+        uint32_t player_segment_id = 0;
+        float segment_distance_travelled = 0.0f;
+        float tunnel_distance_travelled = 0.0f;
+        float reward = 0.0f;
+        bool done = false;
+        bool truncated = false;
+
+        void update_player_segment();
+        void reset_player();
+        void update_state(const glm::vec3& pos, const glm::vec3& dir, const glm::vec3& up);
+        bool is_colliding(const glm::vec3& pos);
+        WallSample sample_wall(const glm::vec3& pos, uint32_t segment_hint);
+        float distance_to_wall(const glm::vec3& ro, const glm::vec3& rd);
+    };
+} // namespace ve
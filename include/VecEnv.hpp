@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MoveActions.hpp"
+#include "TunnelEnv.hpp"
+
+namespace ve
+{
+    // steps multiple independent tunnel environments in lockstep such that the policy can be evaluated for all of them at once
+    class VecEnv
+    {
+    public:
+        VecEnv(uint32_t env_count, uint32_t seed = 0, float time_diff = 0.016667f, uint32_t max_steps = 1200);
+        void reset();
+        // reset only the environments that are done such that every environment is always running
+        void reset_done();
+        // environments that are already done are not stepped and keep their last state
+        void step(const std::vector<MoveActionFlags::type>& actions);
+        uint32_t get_env_count() const;
+        // structure of arrays layout: state component i of environment e is stored at i * env_count + e
+        const std::vector<float>& get_states() const;
+        const std::vector<float>& get_rewards() const;
+        const std::vector<uint8_t>& get_dones() const;
+        // subset of the done environments that only hit the step limit
+        const std::vector<uint8_t>& get_truncated() const;
+        bool is_all_done() const;
+        float get_distance(uint32_t env_idx) const;
+
+    private:
+        std::vector<TunnelEnv> envs;
+        std::vector<float> states;
+        std::vector<float> rewards;
+        std::vector<uint8_t> dones;
+        std::vector<uint8_t> truncated;
+
+        void store_state(uint32_t env_idx);
+    };
+} // namespace ve
@@ -12,6 +12,7 @@
 #include "Storage.hpp"
 #include "vk/Timer.hpp"
 #include "vk/Lighting.hpp"
+#include "vk/ReadbackRing.hpp"
 
 namespace ve
 {
@@ -22,7 +23,7 @@ public:
     void self_destruct();
     void reload_shaders();
     void load_scene(const std::string& filename);
-    void restart();
+    void restart(uint32_t seed);
 
 public:
     const VulkanMainContext& vmc;
@@ -32,6 +33,7 @@ public:
     Scene scene;
     UI ui;
     Lighting lighting;
+    ReadbackRing readback_ring;
     std::vector<Synchronization> syncs;
     std::vector<DeviceTimer> timers;
 
@@ -4,6 +4,7 @@
 
 #include "vk/common.hpp"
 #include "ve_log.hpp"
+#include "vk/ReadbackRing.hpp"
 #include "vk/VulkanCommandContext.hpp"
 #include "vk/VulkanMainContext.hpp"
 
@@ -29,16 +30,21 @@ namespace ve
             std::vector<uint32_t> queue_family_indices_vec = {queue_family_indices...};
             if (device_local)
             {
-                std::tie(buffer, vmaa) = create_buffer((usage_flags | vk::BufferUsageFlagBits::eTransferDst), {}, device_local, queue_family_indices_vec);
+                std::tie(buffer, vmaa) = create_buffer((usage_flags | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc), {}, device_local, queue_family_indices_vec);
             }
             else
             {
-                std::tie(buffer, vmaa) = create_buffer(usage_flags, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, device_local, queue_family_indices_vec);
+                // host visible buffers stay mapped for their whole lifetime as most of them are updated every frame
+                VmaAllocationInfo vai;
+                std::tie(buffer, vmaa) = create_buffer(usage_flags, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT, device_local, queue_family_indices_vec, &vai);
+                mapped_mem = static_cast<uint8_t*>(vai.pMappedData);
             }
         }
 
         void self_destruct()
         {
+            // uploads to the buffer may still be pending
+            if (device_local) vcc.upload_context.wait_idle();
             vmaDestroyBuffer(vmc.va, buffer, vmaa);
         }
 
@@ -64,61 +70,29 @@ namespace ve
 
             if (device_local)
             {
-                auto [staging_buffer, staging_vmaa] = create_buffer((vk::BufferUsageFlagBits::eTransferSrc), VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, true, {vmc.queue_family_indices.transfer});
-                void* mapped_mem;
-                vmaMapMemory(vmc.va, staging_vmaa, &mapped_mem);
-                memset(mapped_mem, 0, byte_count);
-                vmaUnmapMemory(vmc.va, staging_vmaa);
-
-                vk::CommandBuffer& cb(vcc.begin(vcc.transfer_cb[0]));
-
-                vk::BufferCopy copy_region{};
-                copy_region.srcOffset = 0;
-                copy_region.dstOffset = 0;
-                copy_region.size = byte_count;
-                cb.copyBuffer(staging_buffer, buffer, copy_region);
-                vcc.submit_transfer(cb, true);
-
-                vmaDestroyBuffer(vmc.va, staging_buffer, staging_vmaa);
+                // recorded into the current upload batch, every later submission of the command context waits for it
+                vcc.upload_context.fill_buffer(buffer, 0, byte_count == byte_size ? VK_WHOLE_SIZE : byte_count, 0);
             }
             else
             {
-                void* mapped_mem;
-                vmaMapMemory(vmc.va, vmaa, &mapped_mem);
                 memset(mapped_mem, 0, byte_count);
-                vmaUnmapMemory(vmc.va, vmaa);
+                vmaFlushAllocation(vmc.va, vmaa, 0, byte_count);
             }
         }
 
-        void update_data_bytes(const void* data, std::size_t byte_count)
+        void update_data_bytes(const void* data, std::size_t byte_count, std::size_t offset = 0)
         {
-            VE_ASSERT(byte_count <= byte_size, "Data is larger than buffer!");
+            VE_ASSERT(offset + byte_count <= byte_size, "Data is larger than buffer!");
 
             if (device_local)
             {
-                auto [staging_buffer, staging_vmaa] = create_buffer((vk::BufferUsageFlagBits::eTransferSrc), VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, true, {vmc.queue_family_indices.transfer});
-                void* mapped_mem;
-                vmaMapMemory(vmc.va, staging_vmaa, &mapped_mem);
-                memcpy(mapped_mem, data, byte_count);
-                vmaUnmapMemory(vmc.va, staging_vmaa);
-
-                vk::CommandBuffer& cb(vcc.begin(vcc.transfer_cb[0]));
-
-                vk::BufferCopy copy_region{};
-                copy_region.srcOffset = 0;
-                copy_region.dstOffset = 0;
-                copy_region.size = byte_count;
-                cb.copyBuffer(staging_buffer, buffer, copy_region);
-                vcc.submit_transfer(cb, true);
-
-                vmaDestroyBuffer(vmc.va, staging_buffer, staging_vmaa);
+                // recorded into the current upload batch, every later submission of the command context waits for it
+                vcc.upload_context.upload_buffer(buffer, offset, data, byte_count);
             }
             else
             {
-                void* mapped_mem;
-                vmaMapMemory(vmc.va, vmaa, &mapped_mem);
-                memcpy(mapped_mem, data, byte_count);
-                vmaUnmapMemory(vmc.va, vmaa);
+                memcpy(mapped_mem + offset, data, byte_count);
+                vmaFlushAllocation(vmc.va, vmaa, offset, byte_count);
             }
         }
 
@@ -156,22 +130,44 @@ namespace ve
                 cb.copyBuffer(buffer, staging_buffer, copy_region);
                 vcc.submit_transfer(cb, true);
 
-                void* mapped_mem;
-                vmaMapMemory(vmc.va, staging_vmaa, &mapped_mem);
-                memcpy(data, mapped_mem, byte_count);
+                void* staging_mem;
+                vmaMapMemory(vmc.va, staging_vmaa, &staging_mem);
+                memcpy(data, staging_mem, byte_count);
                 vmaUnmapMemory(vmc.va, staging_vmaa);
 
                 vmaDestroyBuffer(vmc.va, staging_buffer, staging_vmaa);
             }
             else
             {
-                void* mapped_mem;
-                vmaMapMemory(vmc.va, vmaa, &mapped_mem);
+                vmaInvalidateAllocation(vmc.va, vmaa, 0, byte_count);
                 memcpy(data, mapped_mem, byte_count);
-                vmaUnmapMemory(vmc.va, vmaa);
             }
         }
 
+        // record a copy of the first byte_count bytes into the region of the frame in the readback ring instead of waiting for it
+        // the buffer needs to be device local and all writes to it need to be made available to transfer reads before
+        ReadbackHandle obtain_data_async(vk::CommandBuffer& cb, ReadbackRing& ring, uint32_t frame_idx, std::size_t byte_count)
+        {
+            VE_ASSERT(byte_count <= byte_size, "Cannot get more bytes than size of buffer!");
+            VE_ASSERT(device_local, "Asynchronous readbacks are only supported for device local buffers!");
+
+            const vk::DeviceSize offset = ring.allocate(frame_idx, byte_count);
+            vk::BufferCopy copy_region{};
+            copy_region.srcOffset = 0;
+            copy_region.dstOffset = offset;
+            copy_region.size = byte_count;
+            cb.copyBuffer(buffer, ring.get(), copy_region);
+            vk::BufferMemoryBarrier host_barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, ring.get(), offset, byte_count);
+            cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {}, {host_barrier}, {});
+            return ReadbackHandle(&ring, frame_idx, ring.get_serial(frame_idx), offset, byte_count);
+        }
+
+        template<class T>
+        ReadbackHandle obtain_first_element_async(vk::CommandBuffer& cb, ReadbackRing& ring, uint32_t frame_idx)
+        {
+            return obtain_data_async(cb, ring, frame_idx, sizeof(T));
+        }
+
         template<class T>
         std::vector<T> obtain_data(std::size_t element_count)
         {
@@ -207,7 +203,7 @@ namespace ve
         void* pNext = nullptr;
 
     private:
-        std::pair<vk::Buffer, VmaAllocation> create_buffer(vk::BufferUsageFlags usage_flags, VmaAllocationCreateFlags vma_flags, bool device_local, const std::vector<uint32_t>& queue_family_indices)
+        std::pair<vk::Buffer, VmaAllocation> create_buffer(vk::BufferUsageFlags usage_flags, VmaAllocationCreateFlags vma_flags, bool device_local, const std::vector<uint32_t>& queue_family_indices, VmaAllocationInfo* vai = nullptr)
         {
             vk::BufferCreateInfo bci{};
             bci.sType = vk::StructureType::eBufferCreateInfo;
@@ -220,9 +216,17 @@ namespace ve
             VmaAllocationCreateInfo vaci{};
             vaci.usage = device_local ? VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE : VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
             vaci.flags = vma_flags;
+            vaci.pool = vmc.buffer_pools.get_pool(byte_size, device_local);
             VkBuffer local_buffer;
             VmaAllocation local_vmaa;
-            vmaCreateBuffer(vmc.va, (VkBufferCreateInfo*) (&bci), &vaci, (&local_buffer), &local_vmaa, nullptr);
+            VkResult result = vmaCreateBuffer(vmc.va, (VkBufferCreateInfo*) (&bci), &vaci, (&local_buffer), &local_vmaa, vai);
+            if (result != VK_SUCCESS && vaci.pool != VK_NULL_HANDLE)
+            {
+                // the memory type of the pool does not support the usage of the buffer, so it is allocated from the default pools
+                vaci.pool = VK_NULL_HANDLE;
+                result = vmaCreateBuffer(vmc.va, (VkBufferCreateInfo*) (&bci), &vaci, (&local_buffer), &local_vmaa, vai);
+            }
+            VE_CHECK(vk::Result(result), "Failed to create buffer!");
 
             return std::make_pair(vk::Buffer(local_buffer), local_vmaa);
         }
@@ -234,5 +238,7 @@ namespace ve
         uint64_t element_count;
         vk::Buffer buffer;
         VmaAllocation vmaa;
+        // only set for buffers that are not device local
+        uint8_t* mapped_mem = nullptr;
     };
 } // namespace ve
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "vk/common.hpp"
+#include "vk_mem_alloc.h"
+
+namespace ve
+{
+    // custom vma pools that small buffers are sub-allocated from instead of the default pools of the allocator
+    // there is one pool for persistently mapped host buffers and one for device local buffers, each with the memory type of the typical usage of these buffers
+    class BufferPools
+    {
+    public:
+        void construct(VmaAllocator va);
+        void self_destruct();
+        // returns VK_NULL_HANDLE for buffers that are too large for the pools
+        VmaPool get_pool(vk::DeviceSize byte_size, bool device_local) const;
+        void log_statistics() const;
+
+    private:
+        VmaPool create_pool(const char* name, vk::BufferUsageFlags usage_flags, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags vma_flags);
+        void log_pool_statistics(const char* name, VmaPool pool) const;
+
+        VmaAllocator va = VK_NULL_HANDLE;
+        VmaPool host_pool = VK_NULL_HANDLE;
+        VmaPool device_pool = VK_NULL_HANDLE;
+    };
+} // namespace ve
@@ -4,8 +4,10 @@
 #include "Storage.hpp"
 #include "common.hpp"
 #include "vk/Pipeline.hpp"
+#include "vk/PipelineBuilder.hpp"
 #include "vk/Timer.hpp"
 #include "vk/DescriptorSetHandler.hpp"
+#include "vk/ReadbackRing.hpp"
 
 namespace ve
 {
@@ -14,11 +16,13 @@ namespace ve
     public:
         CollisionHandler(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage);
         void create_buffers(const std::vector<Vertex>& vertices, uint32_t scene_player_start_idx, uint32_t scene_player_idx_count);
-        void construct(const RenderPass& render_pass);
-        void reload_shaders(const RenderPass& render_pass);
+        void construct(const RenderPass& render_pass, PipelineBuilder& pipeline_builder);
+        void reload_shaders(const RenderPass& render_pass, PipelineBuilder& pipeline_builder);
         void self_destruct(bool full = true);
         void draw(vk::CommandBuffer& cb, const glm::mat4& mvp);
-        void compute(uint32_t current_frame, DeviceTimer& timer);
+        // the broadphase restricts the triangle tests to the rings and columns of the tunnel around the player
+        // the results are copied into the readback ring and picked up the next time the frame is computed
+        void compute(uint32_t current_frame, DeviceTimer& timer, ReadbackRing& readback_ring, uint32_t first_segment_uid);
         CollisionResults get_collision_results(uint32_t frame_idx);
         void reset_shader_return_values(uint32_t frame_idx);
         void reset_all_shader_return_values();
@@ -29,19 +33,41 @@ namespace ve
             alignas(16) glm::vec3 max;
         };
 
+        struct TunnelWindow
+        {
+            uint32_t first_ring;
+            uint32_t ring_count;
+            uint32_t first_column;
+            uint32_t column_count;
+        };
+
+        // written by the broadphase shader and used as indirect dispatch of the collision shader
+        struct Broadphase
+        {
+            vk::DispatchIndirectCommand dispatch;
+            uint32_t triangle_count;
+            std::array<TunnelWindow, 3> windows;
+        };
+
         const VulkanMainContext& vmc;
         VulkanCommandContext& vcc;
         Storage& storage;
         uint32_t player_start_idx;
         uint32_t player_idx_count;
         BoundingBox bb;
-        uint32_t bb_buffer;
-        std::vector<uint32_t> return_buffers;
-        uint32_t vertex_buffer;
+        BufferHandle bb_buffer;
+        std::vector<BufferHandle> return_buffers;
+        std::vector<BufferHandle> broadphase_buffers;
+        std::array<ReadbackHandle, frames_in_flight> readbacks;
+        std::array<CollisionResults, frames_in_flight> collision_results;
+        // the return values are reset on the gpu before the next collision computation of the frame
+        std::array<bool, frames_in_flight> reset_pending;
+        BufferHandle vertex_buffer;
         DescriptorSetHandler compute_dsh;
+        Pipeline broadphase_pipeline;
         Pipeline compute_pipeline;
         Pipeline render_pipeline;
 
-        void construct_pipelines(const RenderPass& render_pass);
+        void construct_pipelines(const RenderPass& render_pass, PipelineBuilder& pipeline_builder);
     };
 } // namespace ve
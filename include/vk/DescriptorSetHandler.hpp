@@ -15,6 +15,8 @@ namespace ve
         void add_binding(uint32_t binding, vk::DescriptorType type, vk::ShaderStageFlags stages);
         void add_descriptor(uint32_t binding, Image& image);
         void add_descriptor(uint32_t binding, const Buffer& buffer);
+        // only the first range bytes of the buffer are visible, used for dynamic buffers that are bound with an offset
+        void add_descriptor(uint32_t binding, const Buffer& buffer, vk::DeviceSize range);
         void apply_descriptor_to_new_sets(uint32_t binding, const Buffer& buffer);
         void apply_descriptor_to_new_sets(uint32_t binding, Image& image);
         void reset_auto_apply_bindings();
@@ -53,6 +53,15 @@ namespace ve
             if(image_view_required) create_image_view(usage & vk::ImageUsageFlagBits::eDepthStencilAttachment ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor);
         }
 
+        // used to create an attachment that aliases the memory of another image whose lifetime does not overlap with this one
+        // the memory requirements of this image must fit into the allocation, the allocation stays owned by the other image
+        Image(const VulkanMainContext& vmc, const VulkanCommandContext& vcc, VmaAllocation alias_allocation, uint32_t width, uint32_t height, vk::ImageUsageFlags usage, vk::Format format, const std::vector<uint32_t>& queue_family_indices) : vmc(vmc), format(format), w(width), h(height), c(4), mip_levels(1), layer_count(1), vmaa(alias_allocation), owns_memory(false)
+        {
+            create_aliasing_image(queue_family_indices, usage);
+            layout = vk::ImageLayout::eUndefined;
+            create_image_view(usage & vk::ImageUsageFlagBits::eDepthStencilAttachment ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor);
+        }
+
         void create_sampler(vk::Filter filter = vk::Filter::eLinear, vk::SamplerAddressMode sampler_address_mode = vk::SamplerAddressMode::eRepeat, bool enable_anisotropy = true);
         void self_destruct();
         void transition_image_layout(VulkanCommandContext& vcc, vk::ImageLayout new_layout, vk::PipelineStageFlags src_stage_flags, vk::PipelineStageFlags dst_stage_flags, vk::AccessFlags src_access_flags, vk::AccessFlags dst_access_flags);
@@ -63,6 +72,7 @@ namespace ve
         vk::Image& get_image();
         vk::ImageView& get_view();
         vk::Sampler& get_sampler();
+        VmaAllocation get_allocation() const;
 
     private:
         const VulkanMainContext& vmc;
@@ -74,10 +84,12 @@ namespace ve
         vk::ImageLayout layout;
         vk::Image image;
         VmaAllocation vmaa;
+        bool owns_memory = true;
         vk::ImageView view;
         vk::Sampler sampler;
 
         static std::pair<vk::Image, VmaAllocation> create_image(const std::vector<uint32_t>& queue_family_indices, vk::ImageUsageFlags usage, vk::SampleCountFlagBits sample_count, bool use_mip_levels, vk::Format format, vk::Extent3D extent, uint32_t layer_count, const VmaAllocator& va, bool host_visible = false);
+        void create_aliasing_image(const std::vector<uint32_t>& queue_family_indices, vk::ImageUsageFlags usage);
         void create_image_from_data(const unsigned char* data, VulkanCommandContext& vcc, const std::vector<uint32_t>& queue_family_indices, uint32_t base_mip_map_lvl, vk::ImageUsageFlags usage_flags);
         void create_image_view(vk::ImageAspectFlags aspects);
         void generate_mipmaps(VulkanCommandContext& vcc);
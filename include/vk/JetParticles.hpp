@@ -1,41 +1,43 @@
 #pragma once
 
 #include "vk/Pipeline.hpp"
+#include "vk/PipelineBuilder.hpp"
 #include "Storage.hpp"
 #include "vk/Mesh.hpp"
 #include "vk/common.hpp"
+#include "vk/UploadArena.hpp"
 
 namespace ve
 {
     class JetParticles
     {
     public:
-        JetParticles(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage);
+        JetParticles(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage, UploadArena& upload_arena);
         void self_destruct(bool full = true);
         void create_buffers();
-        void construct(const RenderPass& render_pass, const Mesh& spawn_mesh, const std::vector<uint32_t>& spawn_mesh_model_render_data_buffer, uint32_t spawn_mesh_model_render_data_idx);
-        void reload_shaders(const RenderPass& render_pass);
+        void construct(const RenderPass& render_pass, const Mesh& spawn_mesh, const std::vector<BufferHandle>& spawn_mesh_model_render_data_buffer, uint32_t spawn_mesh_model_render_data_idx, PipelineBuilder& pipeline_builder);
+        void reload_shaders(const RenderPass& render_pass, PipelineBuilder& pipeline_builder);
         void draw(vk::CommandBuffer& cb, GameState& gs);
         void move_step(vk::CommandBuffer& cb, uint32_t current_frame);
 
-        std::vector<uint32_t> vertex_buffers;
+        std::vector<BufferHandle> vertex_buffers;
 
     private:
         static constexpr float max_particle_lifetime = 0.3f;
         const VulkanMainContext& vmc;
         VulkanCommandContext& vcc;
         Storage& storage;
+        UploadArena& upload_arena;
         DescriptorSetHandler render_dsh;
         DescriptorSetHandler compute_dsh;
         ModelRenderData mrd;
-        std::vector<uint32_t> model_render_data_buffers;
         uint32_t spawn_mesh_model_render_data_buffer_count;
         uint32_t spawn_mesh_model_render_data_buffer_idx;
         Pipeline render_pipeline;
         Pipeline move_compute_pipeline;
         Mesh mesh;
         
-        void construct_pipelines(const RenderPass& render_pass);
+        void construct_pipelines(const RenderPass& render_pass, PipelineBuilder& pipeline_builder);
     };
 } // namespace ve
 
@@ -10,22 +10,37 @@ namespace ve
     struct BottomLevelAccelerationStructure {
         vk::AccelerationStructureKHR handle;
         uint64_t deviceAddress = 0;
-        uint32_t buffer;
-        uint32_t scratch_buffer;;
+        BufferHandle buffer;
+        vk::DeviceSize scratch_size = 0;
         bool is_built = false;
+        // static blas are built once and shared by the tlas of both frames
+        bool is_static = false;
+        bool is_compacted = false;
     };
 
     struct TopLevelAccelerationStructure {
         vk::AccelerationStructureKHR handle;
         uint64_t deviceAddress = 0;
-        uint32_t buffer;
-        uint32_t scratch_buffer;
+        BufferHandle buffer;
+        vk::DeviceSize scratch_size = 0;
         bool is_built = false;
+        // number of instances the acceleration structure and the instance buffer were created for
+        uint32_t instance_count = 0;
+    };
+
+    // one scratch buffer per frame in flight that all acceleration structure builds of the frame sub-allocate from
+    struct ScratchArena {
+        BufferHandle buffer;
+        vk::DeviceSize size = 0;
+        vk::DeviceAddress base_address = 0;
+        vk::DeviceSize offset = 0;
+        // buffers replaced by a larger one that may still be used by recorded builds
+        std::vector<BufferHandle> retired_buffers;
     };
 
     struct BLASBuildInfo {
-        uint32_t vertex_buffer_id;
-        uint32_t index_buffer_id;
+        BufferHandle vertex_buffer_id;
+        BufferHandle index_buffer_id;
         const std::vector<uint32_t> index_offsets;
         const std::vector<uint32_t> index_counts;
         vk::DeviceSize vertex_stride;
@@ -37,11 +52,18 @@ namespace ve
     public:
         PathTracer(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage);
         void self_destruct();
-        uint32_t add_blas(vk::CommandBuffer& cb, uint32_t vertex_buffer_id, uint32_t index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, vk::DeviceSize vertex_stride);
+        // dynamic blas have one copy per frame in flight that can be rebuilt with update_blas, static blas are never rebuilt
+        uint32_t add_blas(vk::CommandBuffer& cb, BufferHandle vertex_buffer_id, BufferHandle index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, vk::DeviceSize vertex_stride, bool is_static = false);
+        // copy static blas into right-sized buffers, the command buffer that built them must have finished
+        void compact_static_blas();
+        // destroy scratch buffers that were replaced by larger ones and the scratch memory of the blas builds of add_blas
+        // all command buffers that used them must have finished
+        void release_retired_scratch_buffers();
         uint32_t add_instance(uint32_t blas_idx, const glm::mat4& M, uint32_t custom_index, uint32_t mask);
         void update_instance(uint32_t instance_idx, const glm::mat4& M);
+        // rebuild dirty blas and bring the tlas up to date; it is refitted if only instance transforms changed and skipped if nothing changed
         void create_tlas(vk::CommandBuffer& cb, uint32_t idx);
-        void update_blas(uint32_t vertex_buffer_id, uint32_t index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, uint32_t blas_idx, vk::DeviceSize vertex_stride);
+        void update_blas(BufferHandle vertex_buffer_id, BufferHandle index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, uint32_t blas_idx, vk::DeviceSize vertex_stride);
 
     private:
         const VulkanMainContext& vmc;
@@ -52,8 +74,20 @@ namespace ve
         std::array<std::vector<BLASBuildInfo>, 2> bottomLevelAS_dirty_build_info;
         std::array<std::vector<vk::AccelerationStructureInstanceKHR>, 2> instances;
         std::array<TopLevelAccelerationStructure, 2> topLevelAS;
-        std::array<uint32_t, 2> instances_buffer;
+        std::array<BufferHandle, 2> instances_buffer;
+        std::array<ScratchArena, 2> scratch_arenas;
+        // initial blas builds need more scratch memory than the per-frame rebuilds, so they do not grow the per-frame arenas
+        ScratchArena load_scratch_arena;
+        vk::DeviceSize scratch_alignment = 1;
+        // instance transforms changed since the last tlas update of the frame
+        std::array<bool, 2> instances_dirty = {true, true};
+        // instances were added or blas were rebuilt, which requires a full build of the tlas of the frame
+        std::array<bool, 2> tlas_needs_rebuild = {true, true};
 
-        void create_blas(vk::CommandBuffer& cb, uint32_t vertex_buffer_id, uint32_t index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, vk::DeviceSize vertex_stride, BottomLevelAccelerationStructure& blas);
+        void create_blas(vk::CommandBuffer& cb, BufferHandle vertex_buffer_id, BufferHandle index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, vk::DeviceSize vertex_stride, BottomLevelAccelerationStructure& blas, ScratchArena& arena);
+        // sub-allocate scratch memory for a build, the arena grows if the builds since the last reset do not fit
+        vk::DeviceAddress allocate_scratch(ScratchArena& arena, vk::DeviceSize size);
+        // all builds using the arena are synchronized by a barrier, so the memory can be reused
+        void reset_scratch(ScratchArena& arena);
     };
 } // namespace ve
@@ -11,14 +11,45 @@ namespace ve
     public:
         Pipeline(const VulkanMainContext& vmc);
         void self_destruct();
+        // describe creates the pipeline layout and copies the state of the pipeline, the pipeline itself is created by build
+        void describe(const RenderPass& render_pass, std::optional<vk::DescriptorSetLayout> set_layout, const std::vector<ShaderInfo>& shader_infos, vk::PolygonMode polygon_mode, const std::vector<vk::VertexInputBindingDescription>& binding_descriptions, const std::vector<vk::VertexInputAttributeDescription>& attribute_description, const vk::PrimitiveTopology& primitive_topology, const std::vector<vk::PushConstantRange>& pcrs);
+        void describe(vk::DescriptorSetLayout set_layout, const ShaderInfo& shader_info, uint32_t push_constant_byte_size);
+        // only accesses the device and the pipeline cache, so different pipelines can be built on different threads
+        void build();
         void construct(const RenderPass& render_pass, std::optional<vk::DescriptorSetLayout> set_layout, const std::vector<ShaderInfo>& shader_infos, vk::PolygonMode polygon_mode, const std::vector<vk::VertexInputBindingDescription>& binding_descriptions, const std::vector<vk::VertexInputAttributeDescription>& attribute_description, const vk::PrimitiveTopology& primitive_topology, const std::vector<vk::PushConstantRange>& pcrs);
         void construct(vk::DescriptorSetLayout set_layout, const ShaderInfo& shader_info, uint32_t push_constant_byte_size);
         const vk::Pipeline& get() const;
         const vk::PipelineLayout& get_layout() const;
 
     private:
+        // the specialization info of a ShaderInfo points to data of the caller, so it is copied
+        struct StageDescription
+        {
+            std::string shader_name;
+            vk::ShaderStageFlagBits stage_flag;
+            std::vector<vk::SpecializationMapEntry> spec_entries;
+            std::vector<uint8_t> spec_data;
+        };
+
+        struct GraphicsDescription
+        {
+            vk::RenderPass render_pass;
+            uint32_t attachment_count;
+            vk::PolygonMode polygon_mode;
+            std::vector<vk::VertexInputBindingDescription> binding_descriptions;
+            std::vector<vk::VertexInputAttributeDescription> attribute_descriptions;
+            vk::PrimitiveTopology primitive_topology;
+        };
+
+        void add_stage_description(const ShaderInfo& shader_info);
+        void build_graphics();
+        void build_compute();
+
         const VulkanMainContext& vmc;
         vk::PipelineLayout pipeline_layout;
         vk::Pipeline pipeline;
+        std::vector<StageDescription> stage_descriptions;
+        // only set for graphics pipelines
+        std::optional<GraphicsDescription> graphics_description;
     };
 } // namespace ve
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vector>
+
+#include "vk/Pipeline.hpp"
+
+namespace ve
+{
+    // collects described pipelines and creates all of them at once on worker threads that share the pipeline cache
+    class PipelineBuilder
+    {
+    public:
+        void add(Pipeline& pipeline);
+        // returns after all added pipelines are created
+        void build();
+
+    private:
+        std::vector<Pipeline*> pipelines;
+    };
+} // namespace ve
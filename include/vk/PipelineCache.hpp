@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+#include "vk/common.hpp"
+#include "vk/LogicalDevice.hpp"
+#include "vk/PhysicalDevice.hpp"
+
+namespace ve
+{
+    // pipeline cache that is loaded from disk at startup and written back on shutdown
+    // the file is specific to the vendor, the device and the driver that created it
+    class PipelineCache
+    {
+    public:
+        PipelineCache(const PhysicalDevice& physical_device, const LogicalDevice& logical_device);
+        void self_destruct();
+        const vk::PipelineCache& get() const;
+
+    private:
+        std::vector<char> load_cache_data() const;
+        void save_cache_data() const;
+
+        const LogicalDevice& logical_device;
+        vk::PhysicalDeviceProperties properties;
+        std::string filename;
+        vk::PipelineCache pipeline_cache;
+    };
+} // namespace ve
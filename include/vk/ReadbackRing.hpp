@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+
+#include "ve_log.hpp"
+#include "vk/common.hpp"
+#include "vk/VulkanMainContext.hpp"
+
+namespace ve
+{
+    class ReadbackRing;
+
+    // result of Buffer::obtain_data_async; the data can be read once the frame that recorded the copy has finished on the gpu
+    // and stays valid until the next submission of that frame writes to the ring again
+    class ReadbackHandle
+    {
+    public:
+        ReadbackHandle() = default;
+        ReadbackHandle(const ReadbackRing* ring, uint32_t frame_idx, uint64_t serial, vk::DeviceSize offset, vk::DeviceSize byte_count);
+        bool is_valid() const;
+        bool is_ready() const;
+        void get_bytes(void* data, vk::DeviceSize count) const;
+
+        template<class T>
+        T get() const
+        {
+            T data;
+            get_bytes(&data, sizeof(T));
+            return data;
+        }
+
+    private:
+        const ReadbackRing* ring = nullptr;
+        uint32_t frame_idx = 0;
+        uint64_t serial = 0;
+        vk::DeviceSize offset = 0;
+        vk::DeviceSize byte_count = 0;
+    };
+
+    // persistently mapped host buffer that gpu to cpu copies are recorded into, split into one region per frame in flight
+    // every region counts the frames it was used in, a readback is complete when the frame counter it was recorded in has completed
+    class ReadbackRing
+    {
+    public:
+        ReadbackRing(const VulkanMainContext& vmc, vk::DeviceSize frame_byte_size);
+        void self_destruct();
+        // needs to be called after waiting for the fence of the frame, completes all readbacks of the frame and frees its region
+        void begin_frame(uint32_t frame_idx);
+        // returns the offset of byte_count free bytes in the region of the frame
+        vk::DeviceSize allocate(uint32_t frame_idx, vk::DeviceSize byte_count);
+        uint64_t get_serial(uint32_t frame_idx) const;
+        bool is_complete(uint32_t frame_idx, uint64_t serial) const;
+        void read(void* data, vk::DeviceSize offset, vk::DeviceSize byte_count) const;
+        const vk::Buffer& get() const;
+
+    private:
+        const VulkanMainContext& vmc;
+        vk::DeviceSize frame_byte_size;
+        vk::Buffer buffer;
+        VmaAllocation vmaa;
+        uint8_t* mapped_mem;
+        std::array<vk::DeviceSize, frames_in_flight> offsets;
+        // serial of the readbacks that are currently recorded into the region and serial of the last completed readbacks
+        std::array<uint64_t, frames_in_flight> serials;
+        std::array<uint64_t, frames_in_flight> completed_serials;
+    };
+} // namespace ve
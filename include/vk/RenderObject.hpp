@@ -2,6 +2,7 @@
 
 #include "vk/Model.hpp"
 #include "vk/Pipeline.hpp"
+#include "vk/PipelineBuilder.hpp"
 #include "vk/RenderPass.hpp"
 #include "vk/common.hpp"
 
@@ -14,7 +15,7 @@ namespace ve
         RenderObject(const VulkanMainContext& vmc);
         void self_destruct(bool full = true);
         void add_model_meshes(std::vector<Mesh>& mesh_list);
-        void construct(const RenderPass& render_pass, const std::vector<ShaderInfo>& shader_names, bool reload = false);
+        void construct(const RenderPass& render_pass, const std::vector<ShaderInfo>& shader_names, PipelineBuilder& pipeline_builder, bool reload = false);
         void draw(vk::CommandBuffer& cb, GameState& gs);
         bool get_mesh(const std::string& name, Mesh& mesh);
 
@@ -28,6 +29,6 @@ namespace ve
         Pipeline pipeline;
         Pipeline mesh_view_pipeline;
 
-        void construct_pipelines(const RenderPass& render_pass, const std::vector<ShaderInfo>& shader_infos);
+        void construct_pipelines(const RenderPass& render_pass, const std::vector<ShaderInfo>& shader_infos, PipelineBuilder& pipeline_builder);
     };
 } // namespace ve
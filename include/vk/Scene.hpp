@@ -8,6 +8,7 @@
 #include "CollisionHandler.hpp"
 #include "vk/PathTracer.hpp"
 #include "vk/JetParticles.hpp"
+#include "vk/UploadArena.hpp"
 
 namespace ve
 {
@@ -15,17 +16,17 @@ namespace ve
     {
     public:
         Scene(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage);
-        void construct(const RenderPass& render_pass);
+        void construct(const RenderPass& render_pass, PipelineBuilder& pipeline_builder);
         void self_destruct();
-        void reload_shaders(const RenderPass& render_pass);
+        void reload_shaders(const RenderPass& render_pass, PipelineBuilder& pipeline_builder);
         void load(const std::string& path);
         void translate(const std::string& model, const glm::vec3& trans);
         void scale(const std::string& model, const glm::vec3& scale);
         void rotate(const std::string& model, float degree, const glm::vec3& axis);
         DescriptorSetHandler& get_dsh(ShaderFlavor flavor);
-        void restart();
+        void restart(uint32_t seed);
         void draw(vk::CommandBuffer& cb, GameState& gs, DeviceTimer& timer);
-        void update_game_state(vk::CommandBuffer& cb, GameState& gs, DeviceTimer& timer);
+        void update_game_state(vk::CommandBuffer& cb, GameState& gs, DeviceTimer& timer, ReadbackRing& readback_ring);
         uint32_t get_light_count();
 
         bool loaded = false;
@@ -50,21 +51,23 @@ namespace ve
         std::vector<MeshRenderData> mesh_render_data;
         std::vector<ModelRenderData> model_render_data;
         std::unordered_map<std::string, uint32_t> model_handles;
-        std::vector<uint32_t> bb_mm_buffers;
-        std::vector<uint32_t> frame_data_buffers;
-        uint32_t vertex_buffer;
-        uint32_t index_buffer;
-        // use -1 to encode missing material buffer and/or textures as they are not required
-        int32_t material_buffer = -1;
-        int32_t texture_image = -1;
-        std::array<int32_t, 2> light_buffers = {-1, -1};
-        uint32_t mesh_render_data_buffer;
-        std::vector<uint32_t> model_render_data_buffers;
+        std::vector<BufferHandle> bb_mm_buffers;
+        std::vector<BufferHandle> frame_data_buffers;
+        BufferHandle vertex_buffer;
+        BufferHandle index_buffer;
+        // invalid handles encode missing material buffer and/or textures as they are not required
+        BufferHandle material_buffer;
+        ImageHandle texture_image;
+        std::array<BufferHandle, 2> light_buffers;
+        BufferHandle mesh_render_data_buffer;
+        std::vector<BufferHandle> model_render_data_buffers;
+        // per frame uniform data of the tunnel, fireflies and jet particles
+        UploadArena upload_arena;
         TunnelObjects tunnel_objects;
         CollisionHandler collision_handler;
         PathTracer path_tracer;
         JetParticles jp;
 
-        void construct_pipelines(const RenderPass& render_pass, bool reload);
+        void construct_pipelines(const RenderPass& render_pass, bool reload, PipelineBuilder& pipeline_builder);
     };
 } // namespace ve
@@ -31,14 +31,14 @@ namespace ve
         vk::Format depth_format;
         vk::SwapchainKHR swapchain;
         RenderPass render_pass;
-        uint32_t depth_buffer;
+        ImageHandle depth_buffer;
         std::vector<vk::Image> images;
         std::vector<vk::ImageView> image_views;
         std::vector<vk::Framebuffer> framebuffers;
 
         RenderPass deferred_render_pass;
-        uint32_t deferred_depth_buffer;
-        std::vector<uint32_t> deferred_images;
+        ImageHandle deferred_depth_buffer;
+        std::vector<ImageHandle> deferred_images;
         vk::Framebuffer deferred_framebuffer;
 
         vk::SwapchainKHR create_swapchain();
@@ -47,5 +47,6 @@ namespace ve
         vk::Extent2D choose_extent();
         vk::SurfaceFormatKHR choose_surface_format();
         vk::Format choose_depth_format();
+        bool supports_lazily_allocated_memory() const;
     };
 } // namespace ve
@@ -1,44 +1,52 @@
 #pragma once
 
 #include "vk/Pipeline.hpp"
+#include "vk/PipelineBuilder.hpp"
 #include "vk/RenderPass.hpp"
 #include "vk/common.hpp"
 #include "vk/DescriptorSetHandler.hpp"
+#include "vk/UploadArena.hpp"
+#include "Storage.hpp"
 
 namespace ve
 {
-    class Storage;
-
     class Tunnel
     {
     public:
-        Tunnel(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage);
+        Tunnel(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage, UploadArena& upload_arena);
         void self_destruct(bool full = true);
         void create_buffers();
-        void construct(const RenderPass& render_pass);
-        void reload_shaders(const RenderPass& render_pass);
+        void construct(const RenderPass& render_pass, PipelineBuilder& pipeline_builder);
+        void reload_shaders(const RenderPass& render_pass, PipelineBuilder& pipeline_builder);
         void draw(vk::CommandBuffer& cb, GameState& gs, const glm::vec3& p1, const glm::vec3& p2);
 
-        uint32_t vertex_buffer;
-        uint32_t index_buffer;
+        BufferHandle vertex_buffer;
+        BufferHandle index_buffer;
+        // coarse mesh of the tunnel for collisions and ray queries, the rasterizer uses the fine mesh
+        BufferHandle collision_vertex_buffer;
+        BufferHandle collision_index_buffer;
+        // smallest vertex distance to the ring center for every sample ring in the collision vertex buffer
+        BufferHandle ring_radii_buffer;
 
     private:
         const VulkanMainContext& vmc;
         VulkanCommandContext& vcc;
         Storage& storage;
+        UploadArena& upload_arena;
         DescriptorSetHandler skybox_dsh;
         DescriptorSetHandler render_dsh;
-        uint32_t skybox_vertex_buffer;
+        BufferHandle skybox_vertex_buffer;
         ModelRenderData mrd;
-        std::vector<uint32_t> model_render_data_buffers;
-        uint32_t noise_textures;
-        uint32_t skybox_texture;
+        ImageHandle noise_textures;
+        ImageHandle skybox_texture;
         Pipeline skybox_render_pipeline;
         Pipeline pipeline;
         Pipeline mesh_view_pipeline;
 
-        void construct_pipelines(const RenderPass& render_pass);
+        void construct_pipelines(const RenderPass& render_pass, PipelineBuilder& pipeline_builder);
         void create_noise_textures();
+        // indices of the triangles between the sample rings of all segment slots, see create_buffers
+        static std::vector<uint32_t> create_ring_indices(uint32_t samples, uint32_t vertices);
     };
 } // namespace ve
 
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <boost/align/aligned_allocator.hpp>
+
+namespace ve
+{
+    struct BezierSegment
+    {
+        glm::vec3 p0;
+        glm::vec3 p1;
+        glm::vec3 p2;
+        uint32_t uid;
+    };
+
+    // host side generation of the quadratic Bézier curves the tunnel segments are made of
+    // does not depend on vulkan such that it can be used by the gpu tunnel and headless environments alike
+    class TunnelBezierPoints
+    {
+    public:
+        TunnelBezierPoints(uint32_t seed = 0);
+        // restart with the straight initial segment; the remaining segments need to be added with add_segment
+        void reset();
+        // same as reset but the following segments are generated from the given seed
+        void reset(uint32_t seed);
+        // append a new segment to the end of the tunnel
+        void add_segment();
+        const BezierSegment& get_newest_segment() const;
+        glm::vec3& get_point(uint32_t segment_id, uint32_t bezier_point_idx, bool use_global_id);
+        const std::vector<glm::vec3, boost::alignment::aligned_allocator<glm::vec3, 16>>& get_points() const;
+        bool is_pos_past_segment(const glm::vec3& pos, uint32_t idx, bool use_global_id);
+        // distance of pos projected onto the line from start to end of the segment
+        float get_segment_progress(uint32_t segment_id, const glm::vec3& pos, bool use_global_id);
+        float get_segment_length(uint32_t segment_id, bool use_global_id);
+        glm::vec3 get_player_reset_position();
+        glm::vec3 get_player_reset_normal();
+
+    private:
+        std::vector<glm::vec3, boost::alignment::aligned_allocator<glm::vec3, 16>> points;
+        std::queue<glm::vec3> queue;
+        BezierSegment newest;
+        std::mt19937 rnd;
+        std::uniform_real_distribution<float> dis;
+
+        glm::vec3 random_cosine(const glm::vec3& normal, const float cosine_weight = 40.0f);
+        glm::vec3 pop_queue();
+    };
+} // namespace ve
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <cstdint>
 
 namespace ve
@@ -11,6 +13,15 @@ namespace ve
     // two triangles per vertex on a sample (3 indices per triangle); every sample of a segment except the last one has triangles
     constexpr uint32_t indices_per_segment = (samples_per_segment - 1) * vertices_per_sample * 6;
     constexpr uint32_t index_count = indices_per_segment * segment_count;
+    // coarse mesh for collisions and ray queries made of every collision_ring_stride-th sample ring and every collision_vertex_stride-th vertex of a ring
+    constexpr uint32_t collision_ring_stride = 3;
+    constexpr uint32_t collision_vertex_stride = 8;
+    static_assert((samples_per_segment - 1) % collision_ring_stride == 0 && vertices_per_sample % collision_vertex_stride == 0);
+    constexpr uint32_t collision_samples_per_segment = (samples_per_segment - 1) / collision_ring_stride + 1;
+    constexpr uint32_t collision_vertices_per_sample = vertices_per_sample / collision_vertex_stride;
+    constexpr uint32_t collision_vertex_count = segment_count * collision_samples_per_segment * collision_vertices_per_sample;
+    constexpr uint32_t collision_indices_per_segment = (collision_samples_per_segment - 1) * collision_vertices_per_sample * 6;
+    constexpr uint32_t collision_index_count = collision_indices_per_segment * segment_count;
     constexpr uint32_t fireflies_per_segment = 15;
     constexpr uint32_t firefly_count = fireflies_per_segment * segment_count;
     constexpr uint32_t reservoir_count = 4;
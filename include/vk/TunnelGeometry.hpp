@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include "vk/TunnelBezierPoints.hpp"
+#include "vk/gpu_data/TunnelGpuData.hpp"
+
+namespace ve
+{
+    // host versions of the functions in tunnel.comp that define the shape of the tunnel
+    float cellular(const glm::vec2& P);
+    glm::vec3 bezier_point(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, float t);
+    glm::vec3 bezier_derivative(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, float t);
+    // vector in the plane of a sample circle that is rotated around the plane normal to get the vertex directions
+    glm::vec3 get_sample_plane_vector(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& plane_normal);
+
+    // port of main() in tunnel.comp that writes the samples_per_segment * vertices_per_sample vertices of a segment in the order of the gpu
+    // normals are left at zero as tunnel_normals.comp computes them; the segment uid is stored as float like pack_tunnel_vertex does
+    // uses generate_tunnel_segment_avx2 if possible and generate_tunnel_segment_circles otherwise
+    void generate_tunnel_segment(const BezierSegment& segment, TunnelVertex* vertices);
+    // processes the vertices of a sample circle in lanes of 8; returns false without writing anything if the build or the cpu has no avx2
+    bool generate_tunnel_segment_avx2(const BezierSegment& segment, TunnelVertex* vertices);
+    // fallback without avx2 that only computes the parts depending on the sample circle or the vertex angle once
+    void generate_tunnel_segment_circles(const BezierSegment& segment, TunnelVertex* vertices);
+    // per vertex reference for generate_tunnel_segment that follows the shader line by line
+    void generate_tunnel_segment_scalar(const BezierSegment& segment, TunnelVertex* vertices);
+} // namespace ve
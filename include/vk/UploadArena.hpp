@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+
+#include "Storage.hpp"
+#include "vk/common.hpp"
+#include "vk/VulkanMainContext.hpp"
+
+namespace ve
+{
+    // linear allocator over one persistently mapped buffer per frame in flight for small data that changes every frame
+    // allocations are aligned for dynamic uniform and storage buffer offsets and live until the frame is started again
+    class UploadArena
+    {
+    public:
+        UploadArena(const VulkanMainContext& vmc, Storage& storage);
+        void create_buffers(vk::DeviceSize frame_byte_size);
+        void self_destruct();
+        // needs to be called after waiting for the fence of the frame, previous allocations of the frame are overwritten afterwards
+        void begin_frame(uint32_t frame_idx);
+        // returns the offset of the data in the buffer of the frame
+        uint32_t upload_bytes(uint32_t frame_idx, const void* data, std::size_t byte_count);
+        const Buffer& get_buffer(uint32_t frame_idx) const;
+
+        template<class T>
+        uint32_t upload(uint32_t frame_idx, const T& data)
+        {
+            return upload_bytes(frame_idx, &data, sizeof(T));
+        }
+
+    private:
+        const VulkanMainContext& vmc;
+        Storage& storage;
+        vk::DeviceSize alignment;
+        vk::DeviceSize frame_byte_size;
+        std::array<BufferHandle, frames_in_flight> buffers;
+        std::array<vk::DeviceSize, frames_in_flight> offsets;
+    };
+} // namespace ve
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <unordered_set>
+
+#include "vk/common.hpp"
+#include "vk/CommandPool.hpp"
+#include "vk/VulkanMainContext.hpp"
+
+namespace ve
+{
+    // batches copies of host data into device local buffers and images through a persistently mapped staging ring
+    // every batch is one submission to the transfer queue that signals the next value of a timeline semaphore
+    // work that consumes the uploads needs to wait for the value returned by flush
+    class UploadContext
+    {
+    public:
+        UploadContext(const VulkanMainContext& vmc, vk::DeviceSize staging_byte_size);
+        void self_destruct();
+        void upload_buffer(vk::Buffer dst, vk::DeviceSize dst_offset, const void* data, vk::DeviceSize byte_count);
+        // byte_count needs to be a multiple of 4 or VK_WHOLE_SIZE
+        void fill_buffer(vk::Buffer dst, vk::DeviceSize dst_offset, vk::DeviceSize byte_count, uint32_t value);
+        // transitions all mip levels of the image to transfer dst optimal and copies the data of every layer to the first mip level
+        void upload_image(vk::Image dst, const unsigned char* data, vk::Extent3D extent, uint32_t layer_count, uint32_t pixel_byte_size, uint32_t mip_levels);
+        // submits the recorded batch, returns the semaphore value that is signaled once all uploads until now are finished
+        uint64_t flush();
+        // waits on the host until all uploads until now are finished
+        void wait_idle();
+        const vk::Semaphore& get_semaphore() const;
+
+    private:
+        vk::CommandBuffer& get_command_buffer();
+        // returns the offset of byte_count free bytes in the staging ring, submits and waits for batches if it is full
+        vk::DeviceSize allocate(vk::DeviceSize byte_count);
+        void wait(uint64_t value);
+        void release(uint64_t value);
+        void add_write_barrier(vk::CommandBuffer& cb, vk::Buffer dst);
+
+        const VulkanMainContext& vmc;
+        CommandPool command_pool;
+        std::array<vk::CommandBuffer, upload_batch_count> command_buffers;
+        // bytes of the staging ring that are used by every batch including the bytes that are skipped when wrapping around
+        std::array<vk::DeviceSize, upload_batch_count> batch_byte_counts;
+        vk::Semaphore semaphore;
+        vk::Buffer staging_buffer;
+        VmaAllocation staging_vmaa;
+        uint8_t* staging_mem;
+        vk::DeviceSize staging_byte_size;
+        vk::DeviceSize head = 0;
+        vk::DeviceSize used_byte_count = 0;
+        // semaphore value that the recorded batch signals and last value whose staging bytes have been released
+        uint64_t batch_value = 1;
+        uint64_t released_value = 0;
+        bool recording = false;
+        // buffers written in the recorded batch since the last barrier, writing them again needs another barrier
+        std::unordered_set<VkBuffer> written_buffers;
+    };
+} // namespace ve
@@ -3,6 +3,7 @@
 #include "vk/common.hpp"
 #include "vk/Synchronization.hpp"
 #include "vk/CommandPool.hpp"
+#include "vk/UploadContext.hpp"
 #include "vk/VulkanMainContext.hpp"
 
 namespace ve
@@ -15,9 +16,9 @@ namespace ve
         void add_compute_buffers(uint32_t count);
         void add_transfer_buffers(uint32_t count);
         vk::CommandBuffer& begin(vk::CommandBuffer& cb);
-        void submit_graphics(const vk::CommandBuffer& cb, bool wait_idle) const;
-        void submit_compute(const vk::CommandBuffer& cb, bool wait_idle) const;
-        void submit_transfer(const vk::CommandBuffer& cb, bool wait_idle) const;
+        void submit_graphics(const vk::CommandBuffer& cb, bool wait_idle);
+        void submit_compute(const vk::CommandBuffer& cb, bool wait_idle);
+        void submit_transfer(const vk::CommandBuffer& cb, bool wait_idle);
         void self_destruct();
 
         const VulkanMainContext& vmc;
@@ -25,8 +26,9 @@ namespace ve
         std::vector<vk::CommandBuffer> graphics_cb;
         std::vector<vk::CommandBuffer> compute_cb;
         std::vector<vk::CommandBuffer> transfer_cb;
+        UploadContext upload_context;
 
     private:
-        void submit(const vk::CommandBuffer& cb, const vk::Queue& queue, bool wait_idle) const;
+        void submit(const vk::CommandBuffer& cb, const vk::Queue& queue, bool wait_idle);
     };
 } // namespace ve
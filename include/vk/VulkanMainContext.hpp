@@ -3,9 +3,11 @@
 #include <optional>
 
 #include "vk/common.hpp"
+#include "vk/BufferPools.hpp"
 #include "Window.hpp"
 #include "vk/LogicalDevice.hpp"
 #include "vk/PhysicalDevice.hpp"
+#include "vk/PipelineCache.hpp"
 #include "vk_mem_alloc.h"
 
 namespace ve
@@ -38,6 +40,8 @@ namespace ve
         PhysicalDevice physical_device;
         QueueFamilyIndices queue_family_indices;
         LogicalDevice logical_device;
+        PipelineCache pipeline_cache;
         VmaAllocator va;
+        BufferPools buffer_pools;
     };
 } // namespace ve
@@ -12,6 +12,16 @@ namespace ve
 {
     constexpr uint32_t frames_in_flight = 2;
     constexpr uint32_t distance_directions_count = 5;
+    // bytes that can be read back asynchronously per frame in flight
+    constexpr uint32_t readback_ring_frame_size = 64 * 1024;
+    // bytes of per frame uniform data that can be uploaded per frame in flight
+    constexpr uint32_t upload_arena_frame_size = 64 * 1024;
+    // staging memory for uploads to device local buffers and images, split over the batches that can be in flight
+    constexpr uint32_t upload_staging_byte_size = 64 * 1024 * 1024;
+    constexpr uint32_t upload_batch_count = 4;
+    // buffers up to this size are sub-allocated from the small buffer pools, which grow in blocks of the given size
+    constexpr uint32_t small_buffer_max_byte_size = 64 * 1024;
+    constexpr uint32_t small_buffer_pool_block_size = 4 * 1024 * 1024;
 
     enum class ShaderFlavor
     {
@@ -42,6 +52,10 @@ namespace ve
         glm::mat4 mvp;
     };
 
+    struct PlayerCollisionPushConstants {
+        uint32_t first_segment_uid;
+    };
+
     struct SessionData
     {
         std::vector<float> devicetimings;
@@ -31,6 +31,18 @@ struct FireflyMovePushConstants {
     uint segment_uid;
 };
 
+struct PlayerCollisionPushConstants {
+    uint first_segment_uid;
+};
+
+// window of sample rings and columns of one segment whose triangles are tested for collisions
+struct TunnelWindow {
+    uint first_ring;
+    uint ring_count;
+    uint first_column;
+    uint column_count;
+};
+
 struct TunnelSkyboxPushConstants {
     mat4 mvp;
 };
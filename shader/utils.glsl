@@ -7,3 +7,47 @@ vec3 rotate(vec3 v, vec3 k, float angle)
     return rotated;
 }
 
+
+vec3 bezier_point(in float t, in vec3 p0, in vec3 p1, in vec3 p2)
+{
+    return pow(1 - t, 2) * p0 + (2 - 2 * t) * t * p1 + pow(t, 2) * p2;
+}
+
+// find bézier parameter t of the point on the segment curve closest to pos with a few newton iterations
+float closest_bezier_parameter(in vec3 pos, in vec3 p0, in vec3 p1, in vec3 p2)
+{
+    // start with the projection onto the chord of the segment
+    float t = clamp(dot(pos - p0, p2 - p0) / dot(p2 - p0, p2 - p0), 0.0, 1.0);
+    const vec3 a = p0 - 2 * p1 + p2;
+    const vec3 b = p1 - p0;
+    for (uint i = 0; i < 4; ++i)
+    {
+        vec3 d = bezier_point(t, p0, p1, p2) - pos;
+        vec3 d1 = 2 * (a * t + b);
+        float f = dot(d, d1);
+        float f1 = dot(d1, d1) + dot(d, 2 * a);
+        if (abs(f1) < 1e-8) break;
+        t = clamp(t - f / f1, 0.0, 1.0);
+    }
+    return t;
+}
+
+// frame of the sample ring at t that tunnel.comp places the vertices in; vertex 0 lies in direction u and the vertex at 90 degrees in direction w
+void ring_frame(in float t, in vec3 p0, in vec3 p1, in vec3 p2, out vec3 u, out vec3 w)
+{
+    vec3 plane_normal = normalize((2 - 2 * t) * (p1 - p0) + 2 * t * (p2 - p1));
+    const vec3 first_dir = normalize(p1 - p0);
+    const vec3 cross_vector = abs(dot(first_dir, vec3(1.0, 0.0, 0.0))) >= 0.999999 ? cross(first_dir, normalize(vec3(0.99, 0.0, 0.01))) : cross(first_dir, vec3(1.0, 0.0, 0.0));
+    u = normalize(cross(plane_normal, cross_vector));
+    w = cross(plane_normal, u);
+}
+
+// angle in [0, 2 pi) of pos around the center of the sample ring at t
+float ring_angle(in vec3 pos, in float t, in vec3 p0, in vec3 p1, in vec3 p2)
+{
+    vec3 u, w;
+    ring_frame(t, p0, p1, p2, u, w);
+    vec3 d = pos - bezier_point(t, p0, p1, p2);
+    float angle = atan(dot(d, w), dot(d, u));
+    return angle < 0.0 ? angle + 2.0 * PI : angle;
+}
@@ -0,0 +1,56 @@
+#include "ActorLearner.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "TunnelEnv.hpp"
+#include "vk/Timer.hpp"
+
+// number of trajectories that can wait for the learner before actors have to wait
+constexpr uint32_t trajectory_queue_size = 64;
+constexpr uint32_t publish_interval = 4;
+
+ActorLearner::ActorLearner(const std::string& nn_file, uint32_t episode_count, uint32_t actor_count) : agent(true), trajectory_queue(trajectory_queue_size), started_episode_count(0), stop(false), episode_count(episode_count), actor_count(actor_count)
+{
+    if (nn_file != "") agent.load_from_file(nn_file);
+}
+
+void ActorLearner::run()
+{
+    // parallelism comes from the actors, keep libtorch from spawning its own threads for the tiny network
+    torch::set_num_threads(1);
+    ve::HostTimer timer;
+    agent.publish_policy();
+    std::vector<std::thread> actors;
+    for (uint32_t i = 0; i < actor_count; ++i) actors.emplace_back(&ActorLearner::act, this, i);
+    agent.learn(trajectory_queue, episode_count, publish_interval);
+    stop.store(true);
+    trajectory_queue.close();
+    for (std::thread& actor : actors) actor.join();
+    spdlog::info("Trained {} episodes with {} actors in {} s", episode_count, actor_count, timer.elapsed());
+    agent.save_to_file("nn.pt");
+}
+
+void ActorLearner::act(uint32_t actor_idx)
+{
+    ve::TunnelEnv env(actor_idx);
+    std::mt19937 gen(actor_idx);
+    while (!stop.load() && started_episode_count.fetch_add(1) < episode_count)
+    {
+        // keep the snapshot for the whole episode; the learner publishes new weights by swapping the pointer
+        std::shared_ptr<NeuralNet> policy = agent.get_policy_snapshot();
+        Trajectory trajectory;
+        std::vector<float> state = env.reset();
+        while (!env.is_done())
+        {
+            trajectory.states.insert(trajectory.states.end(), state.begin(), state.end());
+            uint32_t action_index = Agent::sample_action_index(*policy, state, gen);
+            trajectory.action_indices.push_back(action_index);
+            state = env.step(Agent::index_to_action_mask(action_index));
+            trajectory.rewards.push_back(env.get_reward());
+        }
+        trajectory.distance = env.get_distance();
+        // blocks while the learner is behind; fails once the learner is done
+        if (!trajectory_queue.push(std::move(trajectory))) return;
+    }
+}
@@ -2,69 +2,218 @@
 #include "ve_log.hpp"
 #include <ATen/ops/relu.h>
 #include <ATen/ops/sigmoid.h>
+#include <algorithm>
+#include <array>
 #include <random>
 #include <torch/csrc/autograd/anomaly_mode.h>
 #include <torch/serialize.h>
 
 #define GAMMA 0.999
 
+static_assert(PolicyKernel::input_size == NeuralNet::input_size && PolicyKernel::output_size == NeuralNet::output_size);
+
+// enough for the 1200 frame training episodes of MainContext and the headless environments
+constexpr uint32_t rollout_capacity = 2048;
+
+// calculate discounted rewards of one episode and normalize them; returns the total reward of the episode
+float compute_normalized_returns(const float* episode_rewards, uint32_t step_count, uint32_t stride, float* returns)
+{
+    float total_reward = 0.0f;
+    float running_add = 0.0f;
+    float mean = 0.0f;
+    for (int i = step_count - 1; i >= 0; --i)
+    {
+        total_reward += episode_rewards[i * stride];
+        running_add = running_add * GAMMA + episode_rewards[i * stride];
+        returns[i * stride] = running_add;
+        mean += running_add;
+    }
+    mean /= step_count;
+    float variance = 0.0f;
+    for (uint32_t i = 0; i < step_count; ++i) variance += std::pow(returns[i * stride] - mean, 2.0f);
+    const float std_dev = std::sqrt(variance / (step_count - 1));
+    for (uint32_t i = 0; i < step_count; ++i) returns[i * stride] = (returns[i * stride] - mean) / (std_dev + 1e-8);
+    return total_reward;
+}
+
+RolloutBuffer::RolloutBuffer(uint32_t capacity, uint32_t env_count) : capacity(capacity), env_count(env_count), states(capacity * env_count * NeuralNet::input_size), action_indices(capacity * env_count), rewards(capacity * env_count), episode_lengths(env_count, 0)
+{}
+
+void RolloutBuffer::clear()
+{
+    step_count = 0;
+    std::fill(episode_lengths.begin(), episode_lengths.end(), 0);
+}
+
 Agent::Agent(bool train_mode) : nn(std::make_shared<NeuralNet>()), train_mode(train_mode)
 {
     nn->train(train_mode);
     optimizer = std::make_unique<torch::optim::Adam>(nn->parameters(), 0.001);
+    update_policy_kernel();
 }
 
 MoveActionFlags::type Agent::get_action(const std::vector<float>& state)
 {
-    torch::Tensor t = torch::tensor(state);
-    torch::Tensor actions_t = nn->forward(t);
+    if (!train_mode) return get_action(state, gen);
+    torch::NoGradGuard no_grad;
+    torch::Tensor actions_t = nn->forward(torch::from_blob(const_cast<float*>(state.data()), {int64_t(state.size())}));
     std::discrete_distribution<uint32_t> dis(actions_t.const_data_ptr<float>(), actions_t.const_data_ptr<float>() + actions_t.size(0));
     uint32_t action_index = dis(gen);
-    actions.push_back(index_to_action_mask(action_index));
-    action_tensors.push_back(actions_t.unsqueeze(0));
-    action_log_probs.push_back(torch::log2(actions_t[action_index].unsqueeze(0)));
-    return actions.back();
+    prepare_rollout(1);
+    VE_ASSERT(rollout.step_count < rollout.capacity, "Rollout buffer is full ({} steps)!", rollout.capacity);
+    std::copy(state.begin(), state.end(), rollout.states.begin() + rollout.step_count * NeuralNet::input_size);
+    rollout.action_indices[rollout.step_count] = action_index;
+    rollout.step_count++;
+    return index_to_action_mask(action_index);
+}
+
+MoveActionFlags::type Agent::get_action(const std::vector<float>& state, std::mt19937& generator) const
+{
+    std::array<float, PolicyKernel::output_size> probs;
+    policy_kernel.forward(state.data(), probs.data());
+    // walk the cumulative probabilities instead of building a distribution every frame
+    // rounding can leave the sum slightly below one, the last action takes the rest
+    const float u = std::uniform_real_distribution<float>(0.0f, 1.0f)(generator);
+    uint32_t action_index = 0;
+    float cumulative = probs[0];
+    while (u >= cumulative && action_index < probs.size() - 1) cumulative += probs[++action_index];
+    return index_to_action_mask(action_index);
 }
 
 void Agent::add_reward_for_last_action(float reward)
 {
-    rewards.push_back(reward);
+    prepare_rollout(1);
+    VE_ASSERT(rollout.episode_lengths[0] < rollout.step_count, "Reward without a corresponding action ({} rewards for {} actions)!", rollout.episode_lengths[0] + 1, rollout.step_count);
+    rollout.rewards[rollout.episode_lengths[0]++] = reward;
 }
 
 void Agent::optimize()
 {
-    VE_ASSERT(rewards.size() == action_log_probs.size(), "Failed to optimize agent: different number of rewards ({}) and actions ({})!", rewards.size(), action_log_probs.size());
-    if (rewards.size() <= 2)
+    prepare_rollout(1);
+    VE_ASSERT(rollout.episode_lengths[0] == rollout.step_count, "Failed to optimize agent: different number of rewards ({}) and actions ({})!", rollout.episode_lengths[0], rollout.step_count);
+    optimize_rollout(rollout.states.data(), rollout.action_indices.data(), rollout.rewards.data(), rollout.episode_lengths, rollout.step_count, 1);
+    rollout.clear();
+}
+
+std::vector<MoveActionFlags::type> Agent::get_actions(const torch::Tensor& states)
+{
+    torch::NoGradGuard no_grad;
+    const uint32_t env_count = states.size(0);
+    torch::Tensor contiguous_states = states.contiguous();
+    torch::Tensor probs = nn->forward(contiguous_states);
+    std::vector<MoveActionFlags::type> batch_actions(env_count);
+    std::vector<int64_t> action_indices(env_count);
+    for (uint32_t i = 0; i < env_count; ++i)
     {
-        clear_buffers();
-        return;
+        const float* row = probs.const_data_ptr<float>() + i * probs.size(1);
+        std::discrete_distribution<uint32_t> dis(row, row + probs.size(1));
+        action_indices[i] = dis(gen);
+        batch_actions[i] = index_to_action_mask(action_indices[i]);
     }
-    // Calculate discounted rewards
-    float c = 0;
-    for (auto r : rewards) c += r;
-    std::cout << "Total Reward: " << c << std::endl;
-    float running_add = 0.0f;
-    std::vector<float> discounted_rewards(rewards.size(), 0.0f);
-    for (int i = rewards.size() - 1; i >= 0; --i)
+    if (train_mode)
     {
-        running_add = running_add * GAMMA + rewards[i];
-        discounted_rewards[i] = running_add;
+        prepare_rollout(env_count);
+        VE_ASSERT(rollout.step_count < rollout.capacity, "Rollout buffer is full ({} steps)!", rollout.capacity);
+        std::copy_n(contiguous_states.const_data_ptr<float>(), env_count * NeuralNet::input_size, rollout.states.begin() + rollout.step_count * env_count * NeuralNet::input_size);
+        std::copy(action_indices.begin(), action_indices.end(), rollout.action_indices.begin() + rollout.step_count * env_count);
+        rollout.step_count++;
     }
+    return batch_actions;
+}
 
-    // Normalize the discounted rewards
-    torch::Tensor returns = torch::tensor(discounted_rewards, torch::requires_grad()).unsqueeze(1);
-    returns = (returns - returns.mean()) / (returns.std() + 1e-8);
-    std::vector<torch::Tensor> policy_loss;
-    for (uint32_t i = 0; i < action_log_probs.size(); ++i)
+void Agent::add_rewards_for_last_actions(const std::vector<float>& step_rewards, const std::vector<uint8_t>& active)
+{
+    // environments are active for a contiguous range of steps from the start of the batch
+    for (uint32_t i = 0; i < step_rewards.size(); ++i)
     {
-        policy_loss.push_back(-action_log_probs[i] * returns[i]);
+        if (active[i]) rollout.rewards[(rollout.episode_lengths[i]++) * rollout.env_count + i] = step_rewards[i];
     }
+}
 
+void Agent::optimize_batch()
+{
+    optimize_rollout(rollout.states.data(), rollout.action_indices.data(), rollout.rewards.data(), rollout.episode_lengths, rollout.step_count, rollout.env_count);
+    rollout.clear();
+}
+
+void Agent::optimize(const Trajectory& trajectory)
+{
+    const uint32_t step_count = trajectory.rewards.size();
+    VE_ASSERT(step_count == trajectory.action_indices.size(), "Failed to optimize agent: different number of rewards ({}) and actions ({})!", step_count, trajectory.action_indices.size());
+    optimize_rollout(trajectory.states.data(), trajectory.action_indices.data(), trajectory.rewards.data(), std::vector<uint32_t>{step_count}, step_count, 1);
+}
+
+void Agent::prepare_rollout(uint32_t env_count)
+{
+    if (rollout.env_count != env_count) rollout = RolloutBuffer(rollout_capacity, env_count);
+}
+
+void Agent::optimize_rollout(const float* states, const int64_t* action_indices, const float* rewards, const std::vector<uint32_t>& episode_lengths, uint32_t step_count, uint32_t env_count)
+{
+    std::vector<float> returns(step_count * env_count, 0.0f);
+    std::vector<uint8_t> mask(step_count * env_count, 0);
+    float total_reward = 0.0f;
+    uint32_t optimized_env_count = 0;
+    for (uint32_t e = 0; e < env_count; ++e)
+    {
+        VE_ASSERT(episode_lengths[e] <= step_count, "Failed to optimize agent: more rewards ({}) than actions ({})!", episode_lengths[e], step_count);
+        if (episode_lengths[e] <= 2) continue;
+        total_reward += compute_normalized_returns(rewards + e, episode_lengths[e], env_count, returns.data() + e);
+        for (uint32_t i = 0; i < episode_lengths[e]; ++i) mask[i * env_count + e] = 1;
+        optimized_env_count++;
+    }
+    if (optimized_env_count == 0) return;
+    std::cout << "Total Reward: " << total_reward / optimized_env_count << std::endl;
+
+    // the autograd graph only exists during optimization: recompute the log probabilities of all stored steps in one forward pass
+    const int64_t row_count = int64_t(step_count) * env_count;
+    torch::Tensor states_t = torch::from_blob(const_cast<float*>(states), {row_count, NeuralNet::input_size});
+    torch::Tensor indices_t = torch::from_blob(const_cast<int64_t*>(action_indices), {row_count, 1}, torch::kInt64);
+    torch::Tensor log_probs = torch::log2(nn->forward(states_t).gather(1, indices_t).squeeze(1));
+    torch::Tensor returns_t = torch::from_blob(returns.data(), {row_count});
+    torch::Tensor mask_t = torch::from_blob(mask.data(), {row_count}, torch::kUInt8).to(torch::kBool);
     optimizer->zero_grad();
-    torch::Tensor loss = torch::cat(policy_loss).sum();
+    torch::Tensor loss = -(log_probs * returns_t).masked_select(mask_t).sum();
     loss.backward();
     optimizer->step();
-    clear_buffers();
+}
+
+void Agent::learn(MPSCQueue<Trajectory>& queue, uint32_t episode_count, uint32_t publish_interval)
+{
+    for (uint32_t iteration = 0; iteration < episode_count;)
+    {
+        Trajectory trajectory;
+        if (!queue.pop(trajectory)) break;
+        std::cout << "Distance: " << trajectory.distance << std::endl;
+        std::cout << "Iteration: " << iteration++ << std::endl;
+        optimize(trajectory);
+        if (iteration % publish_interval == 0) publish_policy();
+    }
+}
+
+void Agent::publish_policy()
+{
+    // copy weights into a new network such that actors can keep using their snapshot while the learner continues
+    std::shared_ptr<NeuralNet> snapshot = std::make_shared<NeuralNet>();
+    torch::NoGradGuard no_grad;
+    std::vector<torch::Tensor> src_parameters = nn->parameters();
+    std::vector<torch::Tensor> dst_parameters = snapshot->parameters();
+    for (uint32_t i = 0; i < src_parameters.size(); ++i) dst_parameters[i].copy_(src_parameters[i]);
+    snapshot->eval();
+    policy_snapshot.store(snapshot, std::memory_order_release);
+}
+
+std::shared_ptr<NeuralNet> Agent::get_policy_snapshot() const
+{
+    return policy_snapshot.load(std::memory_order_acquire);
+}
+
+uint32_t Agent::sample_action_index(NeuralNet& policy, const std::vector<float>& state, std::mt19937& gen)
+{
+    torch::NoGradGuard no_grad;
+    torch::Tensor actions_t = policy.forward(torch::from_blob(const_cast<float*>(state.data()), {int64_t(state.size())}));
+    std::discrete_distribution<uint32_t> dis(actions_t.const_data_ptr<float>(), actions_t.const_data_ptr<float>() + actions_t.size(0));
+    return dis(gen);
 }
 
 bool Agent::is_training()
@@ -80,6 +229,19 @@ void Agent::save_to_file(const std::string& filename)
 void Agent::load_from_file(const std::string& filename)
 {
     torch::load(nn, filename);
+    update_policy_kernel();
+}
+
+void Agent::update_policy_kernel()
+{
+    torch::NoGradGuard no_grad;
+    auto parameters = nn->named_parameters();
+    for (uint32_t i = 0; i < PolicyKernel::layer_count; ++i)
+    {
+        torch::Tensor weight = parameters["fc" + std::to_string(i) + ".weight"].contiguous();
+        torch::Tensor bias = parameters["fc" + std::to_string(i) + ".bias"].contiguous();
+        policy_kernel.set_layer(i, weight.const_data_ptr<float>(), bias.const_data_ptr<float>());
+    }
 }
 
 MoveActionFlags::type Agent::index_to_action_mask(uint32_t idx)
@@ -98,11 +260,3 @@ MoveActionFlags::type Agent::index_to_action_mask(uint32_t idx)
         default: return MoveActionFlags::NoMove;
     }
 }
-
-void Agent::clear_buffers()
-{
-    action_tensors.clear();
-    rewards.clear();
-    action_log_probs.clear();
-}
-
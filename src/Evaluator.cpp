@@ -0,0 +1,100 @@
+#include "Evaluator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <thread>
+
+#include "json.hpp"
+#include "TunnelEnv.hpp"
+#include "vk/Timer.hpp"
+
+// same number of lifes as in the game (GameData::player_lifes)
+constexpr uint32_t evaluation_player_lifes = 3;
+
+// mean, standard deviation and quantiles of the values
+template<class T>
+nlohmann::json get_distribution(std::vector<T> values)
+{
+    std::sort(values.begin(), values.end());
+    const double mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+    double variance = 0.0;
+    for (T value : values) variance += (value - mean) * (value - mean);
+    auto quantile = [&](double q) { return values[std::min(size_t(q * values.size()), values.size() - 1)]; };
+    nlohmann::json distribution;
+    distribution["mean"] = mean;
+    distribution["std"] = std::sqrt(variance / values.size());
+    distribution["min"] = values.front();
+    distribution["p10"] = quantile(0.1);
+    distribution["p25"] = quantile(0.25);
+    distribution["median"] = quantile(0.5);
+    distribution["p75"] = quantile(0.75);
+    distribution["p90"] = quantile(0.9);
+    distribution["max"] = values.back();
+    return distribution;
+}
+
+Evaluator::Evaluator(const std::string& nn_file, uint32_t episode_count, uint32_t thread_count, uint32_t seed, uint32_t max_steps) : nn_file(nn_file), agent(false), results(episode_count), thread_count(thread_count), seed(seed), max_steps(max_steps)
+{
+    VE_ASSERT(episode_count > 0, "Evaluation needs at least one episode!");
+    VE_ASSERT(nn_file != "", "Evaluation needs a neural network checkpoint!");
+    agent.load_from_file(nn_file);
+    if (this->thread_count == 0) this->thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void Evaluator::run(const std::string& report_file)
+{
+    ve::HostTimer timer;
+    std::atomic<uint32_t> next_episode(0);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < thread_count; ++i) threads.emplace_back(&Evaluator::evaluate_episodes, this, std::ref(next_episode));
+    for (std::thread& thread : threads) thread.join();
+    const float elapsed = timer.elapsed();
+
+    std::vector<float> distances;
+    std::vector<uint32_t> lifes_lost;
+    std::vector<uint32_t> steps;
+    nlohmann::json episodes = nlohmann::json::array();
+    for (const EpisodeResult& result : results)
+    {
+        distances.push_back(result.distance);
+        lifes_lost.push_back(result.lifes_lost);
+        steps.push_back(result.steps);
+        episodes.push_back({{"seed", result.seed}, {"distance", result.distance}, {"lifes_lost", result.lifes_lost}, {"steps", result.steps}});
+    }
+    const uint64_t total_steps = std::accumulate(steps.begin(), steps.end(), uint64_t(0));
+    nlohmann::json report;
+    report["checkpoint"] = nn_file;
+    report["episode_count"] = results.size();
+    report["thread_count"] = thread_count;
+    report["seed"] = seed;
+    report["max_steps"] = max_steps;
+    report["player_lifes"] = evaluation_player_lifes;
+    report["distance"] = get_distribution(distances);
+    report["lifes_lost"] = get_distribution(lifes_lost);
+    report["steps"] = get_distribution(steps);
+    report["total_steps"] = total_steps;
+    report["seconds"] = elapsed;
+    report["steps_per_second"] = total_steps / elapsed;
+    report["episodes"] = episodes;
+
+    std::ofstream file(report_file);
+    VE_ASSERT(file.is_open(), "Failed to open evaluation report file \"{}\"", report_file);
+    file << report.dump(4) << std::endl;
+    spdlog::info("Evaluated {} episodes with {} threads: mean distance {}, {} steps/s", results.size(), thread_count, report["distance"]["mean"].get<double>(), total_steps / elapsed);
+}
+
+void Evaluator::evaluate_episodes(std::atomic<uint32_t>& next_episode)
+{
+    // every episode only depends on its seed, not on the thread that simulates it
+    for (uint32_t episode = next_episode.fetch_add(1); episode < results.size(); episode = next_episode.fetch_add(1))
+    {
+        const uint32_t episode_seed = seed + episode;
+        ve::TunnelEnv env(episode_seed, 0.016667f, max_steps, evaluation_player_lifes);
+        std::mt19937 gen(episode_seed);
+        while (!env.is_done()) env.step(agent.get_action(env.get_state(), gen));
+        results[episode] = EpisodeResult{episode_seed, env.get_distance(), env.get_lifes_lost(), env.get_step_count()};
+    }
+}
@@ -0,0 +1,84 @@
+#include "HeadlessContext.hpp"
+
+#include <iostream>
+
+#include "vk/Timer.hpp"
+
+HeadlessContext::HeadlessContext(const std::string& nn_file, uint32_t episode_count, uint32_t env_count, bool use_ppo) : envs(env_count), agent(true), episode_count(episode_count)
+{
+    if (use_ppo) ppo_agent = std::make_unique<PPOAgent>(env_count);
+    if (nn_file == "") return;
+    if (ppo_agent) ppo_agent->load_from_file(nn_file);
+    else agent.load_from_file(nn_file);
+}
+
+void HeadlessContext::run()
+{
+    if (ppo_agent)
+    {
+        run_ppo();
+        return;
+    }
+    ve::HostTimer timer;
+    uint64_t total_steps = 0;
+    const uint32_t env_count = envs.get_env_count();
+    // every iteration runs one episode in each of the environments and optimizes with all of them at once
+    for (uint32_t iteration = 0; iteration * env_count < episode_count; ++iteration)
+    {
+        envs.reset();
+        std::vector<uint8_t> active(env_count, 1);
+        while (!envs.is_all_done())
+        {
+            // states are stored as [8, N], the transposed view is the [N, 8] batch for the policy
+            torch::Tensor states = torch::from_blob(const_cast<float*>(envs.get_states().data()), {ve::TunnelEnv::state_size, env_count}).t();
+            std::vector<MoveActionFlags::type> actions = agent.get_actions(states);
+            for (uint32_t i = 0; i < env_count; ++i) active[i] = !envs.get_dones()[i];
+            envs.step(actions);
+            agent.add_rewards_for_last_actions(envs.get_rewards(), active);
+            for (uint32_t i = 0; i < env_count; ++i) total_steps += active[i];
+        }
+        float distance = 0.0f;
+        for (uint32_t i = 0; i < env_count; ++i) distance += envs.get_distance(i);
+        std::cout << "Distance: " << distance / env_count << std::endl;
+        std::cout << "Iteration: " << iteration << std::endl;
+        agent.optimize_batch();
+    }
+    spdlog::info("Simulated {} steps with {} steps/s", total_steps, total_steps / timer.elapsed());
+    agent.save_to_file("nn.pt");
+}
+
+void HeadlessContext::run_ppo()
+{
+    ve::HostTimer timer;
+    uint64_t total_steps = 0;
+    const uint32_t env_count = envs.get_env_count();
+    envs.reset();
+    uint32_t finished_episode_count = 0;
+    // environments are reset individually such that every rollout is a fixed number of steps of all environments
+    for (uint32_t iteration = 0; finished_episode_count < episode_count; ++iteration)
+    {
+        float distance = 0.0f;
+        uint32_t rollout_episode_count = 0;
+        while (!ppo_agent->is_rollout_full())
+        {
+            torch::Tensor states = torch::from_blob(const_cast<float*>(envs.get_states().data()), {ve::TunnelEnv::state_size, env_count}).t();
+            envs.step(ppo_agent->get_actions(states));
+            // states are viewed directly, so the tensor holds the final states until reset_done
+            ppo_agent->add_rewards_for_last_actions(envs.get_rewards(), envs.get_dones(), envs.get_truncated(), states);
+            total_steps += env_count;
+            for (uint32_t i = 0; i < env_count; ++i)
+            {
+                if (!envs.get_dones()[i]) continue;
+                distance += envs.get_distance(i);
+                rollout_episode_count++;
+            }
+            envs.reset_done();
+        }
+        if (rollout_episode_count > 0) std::cout << "Distance: " << distance / rollout_episode_count << std::endl;
+        std::cout << "Iteration: " << iteration << std::endl;
+        ppo_agent->optimize(torch::from_blob(const_cast<float*>(envs.get_states().data()), {ve::TunnelEnv::state_size, env_count}).t());
+        finished_episode_count += rollout_episode_count;
+    }
+    spdlog::info("Simulated {} steps with {} steps/s", total_steps, total_steps / timer.elapsed());
+    ppo_agent->save_to_file("nn.pt");
+}
@@ -3,7 +3,7 @@
 #include "vk/common.hpp"
 #include "Camera.hpp"
 
-MainContext::MainContext(const std::string& nn_file, bool train_mode, bool disable_rendering) : extent(2000, 1500), vmc(extent.width, extent.height), vcc(vmc), wc(vmc, vcc), camera(60.0f, extent.width, extent.height), gs{.cam = camera}, agent(train_mode)
+MainContext::MainContext(const std::string& nn_file, bool train_mode, bool disable_rendering, uint32_t seed, const std::string& record_file, const std::string& replay_file) : extent(2000, 1500), vmc(extent.width, extent.height), vcc(vmc), wc(vmc, vcc), camera(60.0f, extent.width, extent.height), gs{.cam = camera}, agent(train_mode), seed(seed), record_file(record_file)
 {
     gs.session_data.devicetimings.resize(ve::DeviceTimer::TIMER_COUNT, 0.0f);
     extent = wc.swapchain.get_extent();
@@ -14,6 +14,18 @@ MainContext::MainContext(const std::string& nn_file, bool train_mode, bool disab
         use_agent = true;
         agent.load_from_file(nn_file);
     }
+    if (replay_file != "")
+    {
+        replay.emplace();
+        replay->load_from_file(replay_file);
+        this->seed = replay->get_seed();
+        is_replaying = true;
+        spdlog::info("Replaying {} frames with seed {}", replay->get_frame_count(), this->seed);
+    }
+    else if (record_file != "")
+    {
+        replay.emplace(seed);
+    }
 }
 
 MainContext::~MainContext()
@@ -28,6 +40,8 @@ void MainContext::run()
 {
     EventHandler eh;
     wc.load_scene("escapevulkan.json");
+    // generate the first tunnel from the seed
+    restart(next_tunnel_seed());
     std::vector<float> state;
     for (uint32_t i = 0; i < gs.game_data.collision_results.distances.size(); ++i) state.push_back(gs.game_data.collision_results.distances[i]);
     state.push_back(simulation_steering.get_velocity());
@@ -48,10 +62,17 @@ void MainContext::run()
     while (!quit)
     {
         if (!agent.is_training()) sound_player.set_volume(0, simulation_steering.get_velocity() + 40);
-        else action = agent.get_action(state);
+        ReplayFrame replay_frame;
+        if (is_replaying)
+        {
+            if (replay->is_finished()) break;
+            replay_frame = replay->next_frame();
+            action = replay_frame.actions;
+        }
+        else if (use_agent || agent.is_training()) action = agent.get_action(state);
         float old_distance = gs.game_data.tunnel_distance_travelled + gs.game_data.segment_distance_travelled;
         gs.cam.updateVP(gs.game_data.time_diff);
-        dispatch_pressed_keys(eh, action);
+        const MoveActionFlags::type move_actions = dispatch_pressed_keys(eh, replay_frame, action);
         uint32_t old_player_lifes = gs.game_data.player_lifes;
         try
         {
@@ -66,22 +87,26 @@ void MainContext::run()
         while (SDL_PollEvent(&e))
         {
             quit = e.window.event == SDL_WINDOWEVENT_CLOSE;
-            eh.dispatch_event(e);
+            // the keyboard must not interfere with the recorded input
+            if (!is_replaying) eh.dispatch_event(e);
         }
-        if (agent.is_training())
+        if (use_agent || agent.is_training())
         {
-            float reward = 1.0f;
             for (uint32_t i = 0; i < gs.game_data.collision_results.distances.size(); ++i)
             {
                 state[i] = gs.game_data.collision_results.distances[i];
             }
-            float new_distance = gs.game_data.tunnel_distance_travelled + gs.game_data.segment_distance_travelled;
-            reward += new_distance - old_distance;
-            agent.add_reward_for_last_action(reward);
             state[gs.game_data.collision_results.distances.size()] = simulation_steering.get_velocity();
             state[gs.game_data.collision_results.distances.size() + 1] = simulation_steering.get_rotation_speed().x;
             state[gs.game_data.collision_results.distances.size() + 2] = simulation_steering.get_rotation_speed().y;
         }
+        if (agent.is_training())
+        {
+            float reward = 1.0f;
+            float new_distance = gs.game_data.tunnel_distance_travelled + gs.game_data.segment_distance_travelled;
+            reward += new_distance - old_distance;
+            agent.add_reward_for_last_action(reward);
+        }
         if (gs.game_data.player_lifes < old_player_lifes || (agent.is_training() && gs.game_data.total_frames > 1200))
         {
             if (agent.is_training())
@@ -89,7 +114,7 @@ void MainContext::run()
                 std::cout << "Distance: " << gs.game_data.tunnel_distance_travelled + gs.game_data.segment_distance_travelled << std::endl;
                 std::cout << "Iteration: " << iteration++ << std::endl;
                 agent.optimize();
-                restart();
+                restart(next_tunnel_seed());
             }
             else
             {
@@ -108,25 +133,43 @@ void MainContext::run()
             }
         }
         gs.game_data.total_frames++;
-        gs.game_data.time_diff = agent.is_training() ? 0.016667f : timer.restart();
+        if (is_replaying) gs.game_data.time_diff = replay_frame.time_diff;
+        else gs.game_data.time_diff = agent.is_training() ? 0.016667f : timer.restart();
+        // the time difference is stored with the actions of the frame it was measured after
+        if (replay.has_value() && !is_replaying)
+        {
+            replay_frame.actions = move_actions;
+            replay_frame.time_diff = gs.game_data.time_diff;
+            replay->add_frame(replay_frame);
+        }
         gs.game_data.time += gs.game_data.time_diff;
     }
     if (agent.is_training()) agent.save_to_file("nn.pt");
+    if (replay.has_value() && !is_replaying)
+    {
+        replay->save_to_file(record_file);
+        spdlog::info("Recorded {} frames to {}", replay->get_frame_count(), record_file);
+    }
 }
 
-void MainContext::restart()
+uint32_t MainContext::next_tunnel_seed()
+{
+    return seed + restart_count++;
+}
+
+void MainContext::restart(uint32_t tunnel_seed)
 {
     gs.game_data = ve::GameData();
     gs.cam.reset();
     simulation_steering.reset();
-    wc.restart();
+    wc.restart(tunnel_seed);
 }
 
-void MainContext::dispatch_pressed_keys(EventHandler& eh, const MoveActionFlags::type action)
+MoveActionFlags::type MainContext::dispatch_pressed_keys(EventHandler& eh, ReplayFrame& replay_frame, const MoveActionFlags::type action)
 {
+    MoveActionFlags::type move_actions = action;
     if (gs.game_data.player_lifes > 0)
     {
-        MoveActionFlags::type move_actions = action;
         Steering::Move move;
         if (eh.is_key_pressed(Key::W)) move_actions |= MoveActionFlags::MoveForward;
         if (eh.is_key_pressed(Key::S)) move_actions |= MoveActionFlags::MoveBackward;
@@ -136,20 +179,22 @@ void MainContext::dispatch_pressed_keys(EventHandler& eh, const MoveActionFlags:
         if (eh.is_key_pressed(Key::Down)) move_actions |= MoveActionFlags::RotateDown;
         if(game_mode)
         {
+            if (eh.is_key_pressed(Key::A)) move_actions |= MoveActionFlags::RollLeft;
+            if (eh.is_key_pressed(Key::D)) move_actions |= MoveActionFlags::RollRight;
+            MoveActionFlags::type steering_actions = move_actions;
             if (gs.game_data.player_reset_blink_counter > 0)
             {
                 simulation_steering.reset();
-                move_actions = MoveActionFlags::NoMove;
+                // only rolling is permitted while the player blinks after a reset
+                steering_actions &= MoveActionFlags::RollLeft | MoveActionFlags::RollRight;
             }
-            // enable controller if found, always permit keyboard steering
-            if (eh.is_controller_available())
+            // enable controller if found, always permit keyboard steering; controller input is not part of recordings
+            if (eh.is_controller_available() && !replay.has_value())
             {
                 std::pair<glm::vec2, glm::vec2> joystick_pos = eh.get_controller_joystick_pos();
                 simulation_steering.controller_input(joystick_pos, gs.game_data.time_diff, move);
             }
-            if (eh.is_key_pressed(Key::A)) move_actions |= MoveActionFlags::RollLeft;
-            if (eh.is_key_pressed(Key::D)) move_actions |= MoveActionFlags::RollRight;
-            simulation_steering.keyboard_input(move_actions, gs.game_data.time_diff, move);
+            simulation_steering.keyboard_input(steering_actions, gs.game_data.time_diff, move);
             simulation_steering.step(gs.game_data.time_diff, move);
         }
         else
@@ -168,20 +213,29 @@ void MainContext::dispatch_pressed_keys(EventHandler& eh, const MoveActionFlags:
         camera.rotate(move.rotation_delta.z);
 
         // reset state of keys that are used to execute a one time action
-        if (eh.is_key_released(Key::Plus))
+        // one time actions that change the simulation are recorded and taken from the replay during playback
+        if (is_replaying ? replay_frame.flags & ReplayFrame::IncreaseFreeFlightSpeed : eh.is_key_released(Key::Plus))
         {
             if (free_flight_steering.has_value()) free_flight_steering->increase_speed();
             eh.set_released_key(Key::Plus, false);
+            replay_frame.flags |= ReplayFrame::IncreaseFreeFlightSpeed;
         }
-        if (eh.is_key_released(Key::Minus))
+        if (is_replaying ? replay_frame.flags & ReplayFrame::ReduceFreeFlightSpeed : eh.is_key_released(Key::Minus))
         {
             if (free_flight_steering.has_value()) free_flight_steering->reduce_speed();
             eh.set_released_key(Key::Minus, false);
+            replay_frame.flags |= ReplayFrame::ReduceFreeFlightSpeed;
+        }
+        if (is_replaying)
+        {
+            if (replay_frame.flags & ReplayFrame::MouseLook) camera.onMouseMove(replay_frame.mouse_motion.x, replay_frame.mouse_motion.y);
         }
-        if (eh.is_key_pressed(Key::MouseLeft))
+        else if (eh.is_key_pressed(Key::MouseLeft))
         {
             if (!SDL_GetRelativeMouseMode()) SDL_SetRelativeMouseMode(SDL_TRUE);
-            camera.onMouseMove(eh.mouse_motion.x * 1.5f, eh.mouse_motion.y * 1.5f);
+            replay_frame.mouse_motion = eh.mouse_motion * 1.5f;
+            replay_frame.flags |= ReplayFrame::MouseLook;
+            camera.onMouseMove(replay_frame.mouse_motion.x, replay_frame.mouse_motion.y);
             eh.mouse_motion = glm::vec2(0.0f);
         }
         if (eh.is_key_released(Key::MouseLeft))
@@ -236,9 +290,12 @@ void MainContext::dispatch_pressed_keys(EventHandler& eh, const MoveActionFlags:
         gs.settings.save_screenshot = true;
         eh.set_released_key(Key::F1, false);
     }
-    if (eh.is_key_released(Key::F2))
+    if (is_replaying ? replay_frame.flags & ReplayFrame::Restart : eh.is_key_released(Key::F2))
     {
-        restart();
+        // the seed is recorded such that the playback does not depend on the number of restarts
+        if (!is_replaying) replay_frame.restart_seed = next_tunnel_seed();
+        replay_frame.flags |= ReplayFrame::Restart;
+        restart(replay_frame.restart_seed);
         gs.settings.disable_rendering = false;
         sound_player.play(SoundPlayer::SPACESHIP_THRUST, 0, -1);
         eh.set_released_key(Key::F2, false);
@@ -254,6 +311,20 @@ void MainContext::dispatch_pressed_keys(EventHandler& eh, const MoveActionFlags:
         eh.set_released_key(Key::R, false);
         wc.reload_shaders();
     }
+    // settings that change the simulation can also be changed in the ui, so their state is recorded instead of the keys
+    if (is_replaying)
+    {
+        game_mode = replay_frame.flags & ReplayFrame::GameMode;
+        gs.settings.collision_detection_active = replay_frame.flags & ReplayFrame::CollisionDetection;
+        camera.is_tracking_camera = replay_frame.flags & ReplayFrame::TrackingCamera;
+    }
+    else
+    {
+        if (game_mode) replay_frame.flags |= ReplayFrame::GameMode;
+        if (gs.settings.collision_detection_active) replay_frame.flags |= ReplayFrame::CollisionDetection;
+        if (camera.is_tracking_camera) replay_frame.flags |= ReplayFrame::TrackingCamera;
+    }
+    return move_actions;
 }
 
 
@@ -1,24 +1,36 @@
 #include "NeuralNet.hpp"
+#include <ATen/ops/log_softmax.h>
 #include <ATen/ops/softmax.h>
 
-NeuralNet::NeuralNet()
+NeuralNet::NeuralNet(bool value_head)
 {
-    fc0 = register_module("fc0", torch::nn::Linear(8, 32));
+    fc0 = register_module("fc0", torch::nn::Linear(input_size, 32));
     fc1 = register_module("fc1", torch::nn::Linear(32, 32));
     fc2 = register_module("fc2", torch::nn::Linear(32, 32));
     fc3 = register_module("fc3", torch::nn::Linear(32, 32));
     fc4 = register_module("fc4", torch::nn::Linear(32, 32));
-    fc5 = register_module("fc5", torch::nn::Linear(32, 11));
+    fc5 = register_module("fc5", torch::nn::Linear(32, output_size));
+    if (value_head) fc_value = register_module("fc_value", torch::nn::Linear(32, 1));
 }
 
 torch::Tensor NeuralNet::forward(torch::Tensor x)
+{
+    return torch::softmax(fc5(hidden(x)), -1);
+}
+
+std::pair<torch::Tensor, torch::Tensor> NeuralNet::forward_with_value(torch::Tensor x)
+{
+    x = hidden(x);
+    return {torch::log_softmax(fc5(x), -1), fc_value(x).squeeze(-1)};
+}
+
+torch::Tensor NeuralNet::hidden(torch::Tensor x)
 {
     x = torch::relu(fc0(x));
     x = torch::relu(fc1(x));
     x = torch::relu(fc2(x));
     x = torch::relu(fc3(x));
     x = torch::relu(fc4(x));
-    x = torch::softmax(fc5(x), 0);
     return x;
 }
 
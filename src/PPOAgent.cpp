@@ -0,0 +1,175 @@
+#include "PPOAgent.hpp"
+#include "Agent.hpp"
+#include "ve_log.hpp"
+#include <ATen/ops/clamp.h>
+#include <ATen/ops/exp.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <torch/nn/utils/clip_grad.h>
+#include <torch/serialize.h>
+
+constexpr float discount_factor = 0.99f;
+constexpr float gae_lambda = 0.95f;
+constexpr float clip_epsilon = 0.2f;
+constexpr float value_loss_coefficient = 0.5f;
+constexpr float entropy_coefficient = 0.01f;
+constexpr float max_gradient_norm = 0.5f;
+constexpr uint32_t epoch_count = 4;
+constexpr uint32_t minibatch_count = 4;
+
+PPORollout::PPORollout(uint32_t horizon, uint32_t env_count) : horizon(horizon), env_count(env_count), states(horizon * env_count * NeuralNet::input_size), action_indices(horizon * env_count), log_probs(horizon * env_count), values(horizon * env_count), rewards(horizon * env_count), dones(horizon * env_count), truncated(horizon * env_count), bootstrap_values(horizon * env_count)
+{}
+
+PPOAgent::PPOAgent(uint32_t env_count, uint32_t horizon) : nn(std::make_shared<NeuralNet>(true)), rollout(horizon, env_count)
+{
+    nn->train(true);
+    optimizer = std::make_unique<torch::optim::Adam>(nn->parameters(), torch::optim::AdamOptions(0.0003));
+}
+
+std::vector<MoveActionFlags::type> PPOAgent::get_actions(const torch::Tensor& states)
+{
+    VE_ASSERT(rollout.step_count < rollout.horizon, "PPO rollout is full ({} steps)!", rollout.horizon);
+    torch::NoGradGuard no_grad;
+    const uint32_t env_count = rollout.env_count;
+    torch::Tensor contiguous_states = states.contiguous();
+    auto [log_probs, values] = nn->forward_with_value(contiguous_states);
+    log_probs = log_probs.contiguous();
+    torch::Tensor probs = torch::exp(log_probs);
+    const uint32_t offset = rollout.step_count * env_count;
+    std::vector<MoveActionFlags::type> batch_actions(env_count);
+    for (uint32_t i = 0; i < env_count; ++i)
+    {
+        const float* row = probs.const_data_ptr<float>() + i * NeuralNet::output_size;
+        std::discrete_distribution<uint32_t> dis(row, row + NeuralNet::output_size);
+        const uint32_t action_index = dis(gen);
+        rollout.action_indices[offset + i] = action_index;
+        rollout.log_probs[offset + i] = log_probs.const_data_ptr<float>()[i * NeuralNet::output_size + action_index];
+        rollout.values[offset + i] = values[i].item<float>();
+        batch_actions[i] = Agent::index_to_action_mask(action_index);
+    }
+    std::copy_n(contiguous_states.const_data_ptr<float>(), env_count * NeuralNet::input_size, rollout.states.begin() + offset * NeuralNet::input_size);
+    rollout.step_count++;
+    return batch_actions;
+}
+
+void PPOAgent::add_rewards_for_last_actions(const std::vector<float>& step_rewards, const std::vector<uint8_t>& dones, const std::vector<uint8_t>& truncated, const torch::Tensor& final_states)
+{
+    const uint32_t offset = (rollout.step_count - 1) * rollout.env_count;
+    std::copy(step_rewards.begin(), step_rewards.end(), rollout.rewards.begin() + offset);
+    std::copy(dones.begin(), dones.end(), rollout.dones.begin() + offset);
+    std::copy(truncated.begin(), truncated.end(), rollout.truncated.begin() + offset);
+    if (std::none_of(truncated.begin(), truncated.end(), [](uint8_t t){ return t != 0; })) return;
+    // the final state is gone after the reset, so its value has to be stored now
+    torch::NoGradGuard no_grad;
+    torch::Tensor values = nn->forward_with_value(final_states.contiguous()).second.contiguous();
+    for (uint32_t i = 0; i < rollout.env_count; ++i) rollout.bootstrap_values[offset + i] = truncated[i] ? values.const_data_ptr<float>()[i] : 0.0f;
+}
+
+bool PPOAgent::is_rollout_full() const
+{
+    return rollout.step_count == rollout.horizon;
+}
+
+void PPOAgent::compute_advantages(const torch::Tensor& next_values, std::vector<float>& advantages, std::vector<float>& returns) const
+{
+    const uint32_t env_count = rollout.env_count;
+    for (uint32_t e = 0; e < env_count; ++e)
+    {
+        float gae = 0.0f;
+        float next_value = next_values[e].item<float>();
+        for (int i = rollout.step_count - 1; i >= 0; --i)
+        {
+            const uint32_t idx = i * env_count + e;
+            // only a collision really ends the episode; at the step limit it would go on from the final state
+            float bootstrap_value = next_value;
+            if (rollout.truncated[idx]) bootstrap_value = rollout.bootstrap_values[idx];
+            else if (rollout.dones[idx]) bootstrap_value = 0.0f;
+            const float delta = rollout.rewards[idx] + discount_factor * bootstrap_value - rollout.values[idx];
+            // the environment was reset after a done step, the following steps of the rollout belong to the next episode
+            const float not_done = rollout.dones[idx] ? 0.0f : 1.0f;
+            gae = delta + discount_factor * gae_lambda * not_done * gae;
+            advantages[idx] = gae;
+            returns[idx] = gae + rollout.values[idx];
+            next_value = rollout.values[idx];
+        }
+    }
+    const float mean = std::accumulate(advantages.begin(), advantages.end(), 0.0f) / advantages.size();
+    float variance = 0.0f;
+    for (float a : advantages) variance += (a - mean) * (a - mean);
+    const float std_dev = std::sqrt(variance / advantages.size());
+    for (float& a : advantages) a = (a - mean) / (std_dev + 1e-8f);
+}
+
+void PPOAgent::optimize(const torch::Tensor& next_states)
+{
+    VE_ASSERT(is_rollout_full(), "Failed to optimize agent: rollout is not full ({} of {} steps)!", rollout.step_count, rollout.horizon);
+    const int64_t row_count = int64_t(rollout.horizon) * rollout.env_count;
+    std::vector<float> advantages(row_count);
+    std::vector<float> returns(row_count);
+    {
+        torch::NoGradGuard no_grad;
+        compute_advantages(nn->forward_with_value(next_states.contiguous()).second, advantages, returns);
+    }
+    std::cout << "Total Reward: " << std::accumulate(rollout.rewards.begin(), rollout.rewards.end(), 0.0f) / rollout.env_count << std::endl;
+
+    torch::Tensor states_t = torch::from_blob(rollout.states.data(), {row_count, NeuralNet::input_size});
+    torch::Tensor indices_t = torch::from_blob(rollout.action_indices.data(), {row_count, 1}, torch::kInt64);
+    torch::Tensor old_log_probs_t = torch::from_blob(rollout.log_probs.data(), {row_count});
+    torch::Tensor advantages_t = torch::from_blob(advantages.data(), {row_count});
+    torch::Tensor returns_t = torch::from_blob(returns.data(), {row_count});
+    // every sample is reused epoch_count times in shuffled minibatches
+    std::vector<int64_t> permutation(row_count);
+    std::iota(permutation.begin(), permutation.end(), 0);
+    const int64_t minibatch_size = row_count / minibatch_count;
+    for (uint32_t epoch = 0; epoch < epoch_count; ++epoch)
+    {
+        std::shuffle(permutation.begin(), permutation.end(), gen);
+        for (uint32_t m = 0; m < minibatch_count; ++m)
+        {
+            torch::Tensor idx = torch::from_blob(permutation.data() + m * minibatch_size, {minibatch_size}, torch::kInt64);
+            auto [log_probs, values] = nn->forward_with_value(states_t.index_select(0, idx));
+            torch::Tensor action_log_probs = log_probs.gather(1, indices_t.index_select(0, idx)).squeeze(1);
+            torch::Tensor ratio = torch::exp(action_log_probs - old_log_probs_t.index_select(0, idx));
+            torch::Tensor mb_advantages = advantages_t.index_select(0, idx);
+            torch::Tensor policy_loss = -torch::min(ratio * mb_advantages, torch::clamp(ratio, 1.0f - clip_epsilon, 1.0f + clip_epsilon) * mb_advantages).mean();
+            torch::Tensor value_loss = (values - returns_t.index_select(0, idx)).pow(2).mean();
+            torch::Tensor entropy = -(torch::exp(log_probs) * log_probs).sum(1).mean();
+            torch::Tensor loss = policy_loss + value_loss_coefficient * value_loss - entropy_coefficient * entropy;
+            optimizer->zero_grad();
+            loss.backward();
+            torch::nn::utils::clip_grad_norm_(nn->parameters(), max_gradient_norm);
+            optimizer->step();
+        }
+    }
+    rollout.step_count = 0;
+}
+
+void PPOAgent::save_to_file(const std::string& filename)
+{
+    torch::save(nn, filename);
+}
+
+void PPOAgent::load_from_file(const std::string& filename)
+{
+    // read the layers one by one instead of torch::load such that a missing value head is not an error
+    torch::serialize::InputArchive archive;
+    archive.load_from(filename);
+    torch::NoGradGuard no_grad;
+    for (const auto& layer : nn->named_children())
+    {
+        torch::serialize::InputArchive layer_archive;
+        if (!archive.try_read(layer.key(), layer_archive))
+        {
+            if (layer.key() != "fc_value") VE_THROW("Checkpoint \"{}\" has no layer \"{}\"!", filename, layer.key());
+            spdlog::info("Checkpoint \"{}\" has no value head, starting with an untrained one", filename);
+            continue;
+        }
+        for (auto& parameter : layer.value()->named_parameters(false))
+        {
+            torch::Tensor tensor;
+            if (!layer_archive.try_read(parameter.key(), tensor)) VE_THROW("Checkpoint \"{}\" has no parameter \"{}.{}\"!", filename, layer.key(), parameter.key());
+            parameter.value().copy_(tensor);
+        }
+    }
+}
@@ -0,0 +1,180 @@
+#include "PolicyKernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define VE_POLICY_KERNEL_AVX2
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define VE_POLICY_KERNEL_NEON
+#endif
+
+// y = x * w + b with w stored as [in, out]; optionally followed by relu
+template<uint32_t IN, uint32_t OUT>
+void dense_scalar(const float* x, const float* w, const float* b, float* y, bool relu)
+{
+    for (uint32_t o = 0; o < OUT; ++o) y[o] = b[o];
+    for (uint32_t i = 0; i < IN; ++i)
+    {
+        for (uint32_t o = 0; o < OUT; ++o) y[o] += x[i] * w[i * OUT + o];
+    }
+    if (relu) for (uint32_t o = 0; o < OUT; ++o) y[o] = std::max(y[o], 0.0f);
+}
+
+#if defined(VE_POLICY_KERNEL_AVX2)
+// compiled for avx2 independent of the global compiler flags, only called if the cpu supports it
+template<uint32_t IN, uint32_t OUT>
+__attribute__((target("avx2,fma"))) void dense_avx2(const float* x, const float* w, const float* b, float* y, bool relu)
+{
+    static_assert(OUT % 8 == 0);
+    __m256 acc[OUT / 8];
+    for (uint32_t k = 0; k < OUT / 8; ++k) acc[k] = _mm256_load_ps(b + k * 8);
+    for (uint32_t i = 0; i < IN; ++i)
+    {
+        const __m256 xi = _mm256_set1_ps(x[i]);
+#pragma GCC unroll 4
+        for (uint32_t k = 0; k < OUT / 8; ++k) acc[k] = _mm256_fmadd_ps(xi, _mm256_load_ps(w + i * OUT + k * 8), acc[k]);
+    }
+    const __m256 zero = _mm256_setzero_ps();
+    for (uint32_t k = 0; k < OUT / 8; ++k) _mm256_store_ps(y + k * 8, relu ? _mm256_max_ps(acc[k], zero) : acc[k]);
+}
+#endif
+
+#if defined(VE_POLICY_KERNEL_NEON)
+template<uint32_t IN, uint32_t OUT>
+void dense_neon(const float* x, const float* w, const float* b, float* y, bool relu)
+{
+    static_assert(OUT % 4 == 0);
+    float32x4_t acc[OUT / 4];
+    for (uint32_t k = 0; k < OUT / 4; ++k) acc[k] = vld1q_f32(b + k * 4);
+    for (uint32_t i = 0; i < IN; ++i)
+    {
+        const float32x4_t xi = vdupq_n_f32(x[i]);
+        for (uint32_t k = 0; k < OUT / 4; ++k) acc[k] = vfmaq_f32(acc[k], xi, vld1q_f32(w + i * OUT + k * 4));
+    }
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (uint32_t k = 0; k < OUT / 4; ++k) vst1q_f32(y + k * 4, relu ? vmaxq_f32(acc[k], zero) : acc[k]);
+}
+#endif
+
+PolicyKernel::PolicyKernel() : isa(Isa::Scalar)
+{
+    if (is_supported(Isa::AVX2)) isa = Isa::AVX2;
+    else if (is_supported(Isa::NEON)) isa = Isa::NEON;
+}
+
+bool PolicyKernel::is_supported(Isa isa)
+{
+    switch (isa)
+    {
+#if defined(VE_POLICY_KERNEL_AVX2)
+        case Isa::AVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#if defined(VE_POLICY_KERNEL_NEON)
+        case Isa::NEON: return true;
+#endif
+        case Isa::Scalar: return true;
+        default: return false;
+    }
+}
+
+bool PolicyKernel::set_isa(Isa isa)
+{
+    if (!is_supported(isa)) return false;
+    this->isa = isa;
+    return true;
+}
+
+void PolicyKernel::set_layer(uint32_t layer_idx, const float* weights, const float* bias)
+{
+    // transpose from [out, in] to [in, out]
+    auto transpose = [&](uint32_t in, uint32_t out, uint32_t padded_out, float* dst)
+    {
+        for (uint32_t o = 0; o < out; ++o)
+        {
+            for (uint32_t i = 0; i < in; ++i) dst[i * padded_out + o] = weights[o * in + i];
+        }
+    };
+    if (layer_idx == 0)
+    {
+        transpose(input_size, hidden_size, hidden_size, w0);
+        std::copy_n(bias, hidden_size, b_hidden[0]);
+    }
+    else if (layer_idx < layer_count - 1)
+    {
+        transpose(hidden_size, hidden_size, hidden_size, w_hidden[layer_idx - 1]);
+        std::copy_n(bias, hidden_size, b_hidden[layer_idx]);
+    }
+    else
+    {
+        // padded outputs keep zero weights and bias and are ignored by the softmax
+        transpose(hidden_size, output_size, padded_output_size, w_out);
+        std::copy_n(bias, output_size, b_out);
+    }
+}
+
+void PolicyKernel::forward(const float* state, float* probs) const
+{
+    alignas(32) float x[input_size];
+    alignas(32) float h0[hidden_size];
+    alignas(32) float h1[hidden_size];
+    alignas(32) float out[padded_output_size];
+    std::copy_n(state, input_size, x);
+    float* h_in = h0;
+    float* h_out = h1;
+    switch (isa)
+    {
+#if defined(VE_POLICY_KERNEL_AVX2)
+        case Isa::AVX2:
+            dense_avx2<input_size, hidden_size>(x, w0, b_hidden[0], h_in, true);
+            for (uint32_t l = 0; l < layer_count - 2; ++l)
+            {
+                dense_avx2<hidden_size, hidden_size>(h_in, w_hidden[l], b_hidden[l + 1], h_out, true);
+                std::swap(h_in, h_out);
+            }
+            dense_avx2<hidden_size, padded_output_size>(h_in, w_out, b_out, out, false);
+            break;
+#endif
+#if defined(VE_POLICY_KERNEL_NEON)
+        case Isa::NEON:
+            dense_neon<input_size, hidden_size>(x, w0, b_hidden[0], h_in, true);
+            for (uint32_t l = 0; l < layer_count - 2; ++l)
+            {
+                dense_neon<hidden_size, hidden_size>(h_in, w_hidden[l], b_hidden[l + 1], h_out, true);
+                std::swap(h_in, h_out);
+            }
+            dense_neon<hidden_size, padded_output_size>(h_in, w_out, b_out, out, false);
+            break;
+#endif
+        default:
+            dense_scalar<input_size, hidden_size>(x, w0, b_hidden[0], h_in, true);
+            for (uint32_t l = 0; l < layer_count - 2; ++l)
+            {
+                dense_scalar<hidden_size, hidden_size>(h_in, w_hidden[l], b_hidden[l + 1], h_out, true);
+                std::swap(h_in, h_out);
+            }
+            dense_scalar<hidden_size, padded_output_size>(h_in, w_out, b_out, out, false);
+            break;
+    }
+    // numerically stable softmax over the actual outputs
+    const float max_value = *std::max_element(out, out + output_size);
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < output_size; ++i)
+    {
+        probs[i] = std::exp(out[i] - max_value);
+        sum += probs[i];
+    }
+    for (uint32_t i = 0; i < output_size; ++i) probs[i] /= sum;
+}
+
+const char* PolicyKernel::get_isa_name() const
+{
+    switch (isa)
+    {
+        case Isa::AVX2: return "AVX2";
+        case Isa::NEON: return "NEON";
+        default: return "scalar";
+    }
+}
@@ -0,0 +1,86 @@
+#include "Replay.hpp"
+
+#include <array>
+#include <fstream>
+
+#include "ve_log.hpp"
+
+constexpr std::array<char, 4> replay_magic{'V', 'E', 'R', 'P'};
+
+Replay::Replay(uint32_t seed) : seed(seed)
+{}
+
+void Replay::add_frame(const ReplayFrame& frame)
+{
+    frames.push_back(frame);
+}
+
+bool Replay::is_finished() const
+{
+    return playback_idx >= frames.size();
+}
+
+const ReplayFrame& Replay::next_frame()
+{
+    VE_ASSERT(!is_finished(), "Replay has no frames left ({} frames)!", frames.size());
+    return frames[playback_idx++];
+}
+
+uint32_t Replay::get_seed() const
+{
+    return seed;
+}
+
+uint32_t Replay::get_frame_count() const
+{
+    return frames.size();
+}
+
+void Replay::save_to_file(const std::string& filename) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    VE_ASSERT(file.is_open(), "Failed to open replay file \"{}\"", filename);
+    const uint32_t frame_count = frames.size();
+    file.write(replay_magic.data(), replay_magic.size());
+    file.write(reinterpret_cast<const char*>(&version), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&seed), sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(&frame_count), sizeof(uint32_t));
+    // floats are stored bitwise such that the playback is exact
+    for (const ReplayFrame& frame : frames)
+    {
+        file.write(reinterpret_cast<const char*>(&frame.actions), sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&frame.flags), sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&frame.restart_seed), sizeof(uint32_t));
+        file.write(reinterpret_cast<const char*>(&frame.mouse_motion.x), sizeof(float));
+        file.write(reinterpret_cast<const char*>(&frame.mouse_motion.y), sizeof(float));
+        file.write(reinterpret_cast<const char*>(&frame.time_diff), sizeof(float));
+    }
+    VE_ASSERT(file.good(), "Failed to write replay file \"{}\"", filename);
+}
+
+void Replay::load_from_file(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    VE_ASSERT(file.is_open(), "Failed to open replay file \"{}\"", filename);
+    std::array<char, 4> magic;
+    uint32_t file_version = 0;
+    uint32_t frame_count = 0;
+    file.read(magic.data(), magic.size());
+    file.read(reinterpret_cast<char*>(&file_version), sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(&seed), sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(&frame_count), sizeof(uint32_t));
+    VE_ASSERT(file.good() && magic == replay_magic, "\"{}\" is not a replay file", filename);
+    VE_ASSERT(file_version == version, "Unsupported replay version {} in \"{}\"", file_version, filename);
+    frames.resize(frame_count);
+    for (ReplayFrame& frame : frames)
+    {
+        file.read(reinterpret_cast<char*>(&frame.actions), sizeof(uint32_t));
+        file.read(reinterpret_cast<char*>(&frame.flags), sizeof(uint32_t));
+        file.read(reinterpret_cast<char*>(&frame.restart_seed), sizeof(uint32_t));
+        file.read(reinterpret_cast<char*>(&frame.mouse_motion.x), sizeof(float));
+        file.read(reinterpret_cast<char*>(&frame.mouse_motion.y), sizeof(float));
+        file.read(reinterpret_cast<char*>(&frame.time_diff), sizeof(float));
+    }
+    VE_ASSERT(file.good(), "Replay file \"{}\" is truncated", filename);
+    playback_idx = 0;
+}
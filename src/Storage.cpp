@@ -7,12 +7,21 @@ namespace ve
     Storage::Storage(const VulkanMainContext& vmc, VulkanCommandContext& vcc) : vmc(vmc), vcc(vcc)
     {}
 
-    void Storage::destroy_buffer(uint32_t idx)
+    template<typename T>
+    void Storage::destroy_resource(std::vector<Slot<T>>& slots, std::vector<uint32_t>& free_slots, uint32_t idx)
     {
-        if (buffers.at(idx).has_value())
+        slots[idx].resource.value().self_destruct();
+        slots[idx].resource.reset();
+        // invalidate all handles to the resource before the slot is reused
+        ++slots[idx].generation;
+        free_slots.push_back(idx);
+    }
+
+    void Storage::destroy_buffer(BufferHandle handle)
+    {
+        if (is_alive(buffers, handle))
         {
-            buffers.at(idx).value().self_destruct();
-            buffers.at(idx).reset();
+            destroy_resource(buffers, free_buffer_slots, handle.idx);
         }
         else
         {
@@ -20,12 +29,11 @@ namespace ve
         }
     }
 
-    void Storage::destroy_image(uint32_t idx)
+    void Storage::destroy_image(ImageHandle handle)
     {
-        if (images.at(idx).has_value())
+        if (is_alive(images, handle))
         {
-            images.at(idx).value().self_destruct();
-            images.at(idx).reset();
+            destroy_resource(images, free_image_slots, handle.idx);
         }
         else
         {
@@ -45,25 +53,24 @@ namespace ve
 
     void Storage::clear()
     {
-        for (auto& b : buffers)
+        // the slots are kept that handles from before stay invalid
+        for (uint32_t i = 0; i < buffers.size(); ++i)
         {
-            if (b.has_value()) b.value().self_destruct();
+            if (buffers[i].resource.has_value()) destroy_resource(buffers, free_buffer_slots, i);
         }
-        buffers.clear();
-        for (auto& i : images)
+        for (uint32_t i = 0; i < images.size(); ++i)
         {
-            if (i.has_value()) i.value().self_destruct();
+            if (images[i].resource.has_value()) destroy_resource(images, free_image_slots, i);
         }
-        images.clear();
         buffer_names.clear();
         image_names.clear();
     }
 
-    Buffer& Storage::get_buffer(uint32_t idx)
+    Buffer& Storage::get_buffer(BufferHandle handle)
     {
-        if (buffers.at(idx).has_value())
+        if (is_alive(buffers, handle))
         {
-            return buffers.at(idx).value();
+            return buffers[handle.idx].resource.value();
         }
         else
         {
@@ -71,11 +78,11 @@ namespace ve
         }
     }
 
-    Image& Storage::get_image(uint32_t idx)
+    Image& Storage::get_image(ImageHandle handle)
     {
-        if (images.at(idx).has_value())
+        if (is_alive(images, handle))
         {
-            return images.at(idx).value();
+            return images[handle.idx].resource.value();
         }
         else
         {
@@ -0,0 +1,263 @@
+#include "TunnelEnv.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+#include <glm/vec2.hpp>
+
+#include "vk/TunnelConstants.hpp"
+#include "vk/TunnelGeometry.hpp"
+
+namespace ve
+{
+    // radius of the sphere that approximates the bounding box of the spaceship
+    constexpr float player_collision_radius = 1.5f;
+    constexpr uint32_t max_ray_steps = 256;
+    constexpr float min_ray_step = 0.1f;
+    constexpr float max_ray_step = 2.0f;
+
+    // parameter of the point on the curve that is closest to pos
+    float closest_bezier_t(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& pos)
+    {
+        float best_t = 0.0f;
+        float best_distance = std::numeric_limits<float>::max();
+        for (uint32_t i = 0; i <= 4; ++i)
+        {
+            const float t = float(i) / 4.0f;
+            const glm::vec3 d = bezier_point(p0, p1, p2, t) - pos;
+            if (glm::dot(d, d) < best_distance)
+            {
+                best_distance = glm::dot(d, d);
+                best_t = t;
+            }
+        }
+        // refine with a few newton iterations on the derivative of the squared distance
+        const glm::vec3 second_derivative = 2.0f * (p2 - 2.0f * p1 + p0);
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            const glm::vec3 d = bezier_point(p0, p1, p2, best_t) - pos;
+            const glm::vec3 tangent = bezier_derivative(p0, p1, p2, best_t);
+            const float denominator = glm::dot(tangent, tangent) + glm::dot(d, second_derivative);
+            if (std::abs(denominator) < 1e-6f) break;
+            best_t = glm::clamp(best_t - glm::dot(d, tangent) / denominator, 0.0f, 1.0f);
+        }
+        return best_t;
+    }
+
+    TunnelEnv::TunnelEnv(uint32_t seed, float time_diff, uint32_t max_steps, uint32_t max_player_lifes) : tunnel_bezier_points(seed), camera(60.0f, 1.0f, 1.0f), state(state_size, 0.0f), time_diff(time_diff), max_steps(max_steps), max_player_lifes(max_player_lifes), player_lifes(max_player_lifes)
+    {
+        reset();
+    }
+
+    const std::vector<float>& TunnelEnv::reset()
+    {
+        tunnel_bezier_points.reset();
+        for (uint32_t i = 1; i < segment_count; ++i) tunnel_bezier_points.add_segment();
+        simulation_steering.reset();
+        camera.reset();
+        step_count = 0;
+        player_lifes = max_player_lifes;
+        player_segment_id = 0;
+        segment_distance_travelled = 0.0f;
+        tunnel_distance_travelled = 0.0f;
+        reward = 0.0f;
+        done = false;
+        truncated = false;
+        update_player_segment();
+        update_state(camera.position, camera.orientation * glm::vec3(0.0f, 0.0f, -1.0f), camera.orientation * glm::vec3(0.0f, -1.0f, 0.0f));
+        return state;
+    }
+
+    const std::vector<float>& TunnelEnv::step(MoveActionFlags::type action)
+    {
+        Steering::Move move;
+        simulation_steering.keyboard_input(action, time_diff, move);
+        simulation_steering.step(time_diff, move);
+        camera.moveFront(move.position_delta.z);
+        camera.onMouseMove(move.rotation_delta.x, move.rotation_delta.y);
+        camera.rotate(move.rotation_delta.z);
+        camera.updateVP(time_diff);
+        step_count++;
+
+        // player object is rotated by 180 degrees around z relative to the camera (see Scene::update_game_state)
+        const glm::vec3 pos = camera.position;
+        const glm::vec3 dir = camera.orientation * glm::vec3(0.0f, 0.0f, -1.0f);
+        const glm::vec3 up = camera.orientation * glm::vec3(0.0f, -1.0f, 0.0f);
+        const float old_distance = tunnel_distance_travelled + segment_distance_travelled;
+        update_player_segment();
+        segment_distance_travelled = tunnel_bezier_points.get_segment_progress(player_segment_id, pos, true);
+        const uint32_t newest_segment_uid = tunnel_bezier_points.get_newest_segment().uid;
+        if (newest_segment_uid - segment_count + 1 + player_local_segment_position < player_segment_id)
+        {
+            // player passed a segment, add distance of passed segment and move tunnel one segment forward
+            tunnel_distance_travelled += tunnel_bezier_points.get_segment_length(player_segment_id - 1, true);
+            segment_distance_travelled = 0.0f;
+            tunnel_bezier_points.add_segment();
+        }
+        reward = 1.0f + tunnel_distance_travelled + segment_distance_travelled - old_distance;
+        const bool collision = is_colliding(pos);
+        if (collision) player_lifes--;
+        truncated = player_lifes > 0 && step_count >= max_steps;
+        done = player_lifes == 0 || truncated;
+        if (!collision || done)
+        {
+            update_state(pos, dir, up);
+            return state;
+        }
+        reset_player();
+        update_state(camera.position, camera.orientation * glm::vec3(0.0f, 0.0f, -1.0f), camera.orientation * glm::vec3(0.0f, -1.0f, 0.0f));
+        return state;
+    }
+
+    const std::vector<float>& TunnelEnv::get_state() const
+    {
+        return state;
+    }
+
+    float TunnelEnv::get_reward() const
+    {
+        return reward;
+    }
+
+    bool TunnelEnv::is_done() const
+    {
+        return done;
+    }
+
+    bool TunnelEnv::is_truncated() const
+    {
+        return truncated;
+    }
+
+    float TunnelEnv::get_distance() const
+    {
+        return tunnel_distance_travelled + segment_distance_travelled;
+    }
+
+    uint32_t TunnelEnv::get_step_count() const
+    {
+        return step_count;
+    }
+
+    uint32_t TunnelEnv::get_lifes_lost() const
+    {
+        return max_player_lifes - player_lifes;
+    }
+
+    void TunnelEnv::reset_player()
+    {
+        // same as the collision handling in Scene::update_game_state but without the blinking phase
+        simulation_steering.reset();
+        camera.position = tunnel_bezier_points.get_player_reset_position();
+        const glm::vec3 normal = tunnel_bezier_points.get_player_reset_normal();
+        if (std::abs(glm::dot(normal, glm::vec3(1.0f, 0.0f, 0.0f))) > 0.999f) camera.orientation = glm::quatLookAt(normal, glm::vec3(0.0f, 1.0f, 0.0f));
+        else camera.orientation = glm::quatLookAt(normal, glm::vec3(1.0f, 0.0f, 0.0f));
+        player_segment_id = tunnel_bezier_points.get_newest_segment().uid + 1 + player_local_segment_position - segment_count;
+        segment_distance_travelled = 0.0f;
+    }
+
+    void TunnelEnv::update_player_segment()
+    {
+        for (uint32_t j = 0; j < segment_count && tunnel_bezier_points.is_pos_past_segment(camera.position, player_segment_id + 1, true); ++j) player_segment_id++;
+    }
+
+    void TunnelEnv::update_state(const glm::vec3& pos, const glm::vec3& dir, const glm::vec3& up)
+    {
+        state[0] = distance_to_wall(pos, dir);
+        for (uint32_t i = 1; i < distance_directions_count; ++i)
+        {
+            // front left down right up; rotate up around dir like utils.glsl
+            const float angle = glm::radians(float(i) * 90.0f);
+            const glm::vec3 rotated_up = up * std::cos(angle) + glm::cross(dir, up) * std::sin(angle) + dir * glm::dot(dir, up) * (1.0f - std::cos(angle));
+            state[i] = distance_to_wall(pos, glm::normalize(dir + rotated_up));
+        }
+        state[distance_directions_count] = simulation_steering.get_velocity();
+        state[distance_directions_count + 1] = simulation_steering.get_rotation_speed().x;
+        state[distance_directions_count + 2] = simulation_steering.get_rotation_speed().y;
+    }
+
+    bool TunnelEnv::is_colliding(const glm::vec3& pos)
+    {
+        // check if player tries to move in the wrong direction
+        if (!tunnel_bezier_points.is_pos_past_segment(pos, player_segment_id > 0 ? player_segment_id - 1 : 0, true)) return true;
+        WallSample sample = sample_wall(pos, player_segment_id);
+        return sample.outside_of_tunnel || sample.clearance < player_collision_radius;
+    }
+
+    TunnelEnv::WallSample TunnelEnv::sample_wall(const glm::vec3& pos, uint32_t segment_hint)
+    {
+        const uint32_t newest_segment_uid = tunnel_bezier_points.get_newest_segment().uid;
+        const uint32_t oldest_segment_uid = newest_segment_uid - std::min(newest_segment_uid, segment_count - 1);
+        const uint32_t first_candidate = std::max(std::min(segment_hint, newest_segment_uid), oldest_segment_uid + 1) - 1;
+        const uint32_t last_candidate = std::min(first_candidate + 2, newest_segment_uid);
+        WallSample sample{.segment_id = first_candidate, .t = 0.0f};
+        glm::vec3 offset;
+        float best_distance = std::numeric_limits<float>::max();
+        for (uint32_t segment_id = first_candidate; segment_id <= last_candidate; ++segment_id)
+        {
+            const glm::vec3& p0 = tunnel_bezier_points.get_point(segment_id, 0, true);
+            const glm::vec3& p1 = tunnel_bezier_points.get_point(segment_id, 1, true);
+            const glm::vec3& p2 = tunnel_bezier_points.get_point(segment_id, 2, true);
+            const float t = closest_bezier_t(p0, p1, p2, pos);
+            const glm::vec3 d = pos - bezier_point(p0, p1, p2, t);
+            if (glm::dot(d, d) < best_distance)
+            {
+                best_distance = glm::dot(d, d);
+                sample.segment_id = segment_id;
+                sample.t = t;
+                offset = d;
+            }
+        }
+        sample.outside_of_tunnel = (sample.segment_id == newest_segment_uid && sample.t >= 1.0f) || (sample.segment_id == oldest_segment_uid && sample.t <= 0.0f);
+
+        // reconstruct the sample ring orientation of tunnel.comp to get the angle of pos around the curve
+        const glm::vec3& p0 = tunnel_bezier_points.get_point(sample.segment_id, 0, true);
+        const glm::vec3& p1 = tunnel_bezier_points.get_point(sample.segment_id, 1, true);
+        const glm::vec3& p2 = tunnel_bezier_points.get_point(sample.segment_id, 2, true);
+        const glm::vec3 plane_normal = glm::normalize(bezier_derivative(p0, p1, p2, sample.t));
+        const glm::vec3 plane_vector = glm::normalize(get_sample_plane_vector(p0, p1, plane_normal));
+        const glm::vec3 planar_offset = offset - plane_normal * glm::dot(offset, plane_normal);
+        float angle = glm::degrees(std::atan2(glm::dot(planar_offset, glm::cross(plane_normal, plane_vector)), glm::dot(planar_offset, plane_vector)));
+        if (angle < 0.0f) angle += 360.0f;
+
+        // same wall displacement as tunnel.comp with the continuous ring parameter instead of the sample circle id
+        const glm::vec2 tex(std::abs(float(sample.segment_id % 2) - sample.t), std::abs(angle / 180.0f - 1.0f));
+        const glm::vec2 scaled_tex(tex.s * 2.0f + float(sample.segment_id), tex.t * 3.0f);
+        const float height = cellular(scaled_tex) * (1.0f - std::pow(sample.t * 2.0f - 1.0f, 2.0f));
+        sample.clearance = (20.0f - height * 12.0f) - glm::length(offset);
+        return sample;
+    }
+
+    float TunnelEnv::distance_to_wall(const glm::vec3& ro, const glm::vec3& rd)
+    {
+        // march along the ray until the wall is crossed and refine the hit with a bisection
+        // returns 0 if nothing was hit, like the ray query in player_tunnel_collision.comp
+        WallSample sample = sample_wall(ro, player_segment_id);
+        if (sample.clearance <= 0.0f || sample.outside_of_tunnel) return 0.0f;
+        float t = 0.0f;
+        for (uint32_t i = 0; i < max_ray_steps; ++i)
+        {
+            const float next_t = t + glm::clamp(sample.clearance * 0.5f, min_ray_step, max_ray_step);
+            WallSample next_sample = sample_wall(ro + rd * next_t, sample.segment_id);
+            if (next_sample.outside_of_tunnel) return 0.0f;
+            if (next_sample.clearance <= 0.0f)
+            {
+                float t_inside = t;
+                float t_outside = next_t;
+                for (uint32_t j = 0; j < 8; ++j)
+                {
+                    const float t_mid = (t_inside + t_outside) * 0.5f;
+                    if (sample_wall(ro + rd * t_mid, sample.segment_id).clearance > 0.0f) t_inside = t_mid;
+                    else t_outside = t_mid;
+                }
+                return (t_inside + t_outside) * 0.5f;
+            }
+            t = next_t;
+            sample = next_sample;
+        }
+        return 0.0f;
+    }
+} // namespace ve
@@ -56,6 +56,7 @@ namespace ve
         ii.Device = vmc.logical_device.get();
         ii.Queue = vmc.get_graphics_queue();
         ii.DescriptorPool = imgui_pool;
+        ii.PipelineCache = vmc.pipeline_cache.get();
         ii.MinImageCount = frames;
         ii.ImageCount = frames;
         ii.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
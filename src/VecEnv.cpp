@@ -0,0 +1,96 @@
+#include "VecEnv.hpp"
+
+#include <algorithm>
+
+namespace ve
+{
+    VecEnv::VecEnv(uint32_t env_count, uint32_t seed, float time_diff, uint32_t max_steps) : states(TunnelEnv::state_size * env_count, 0.0f), rewards(env_count, 0.0f), dones(env_count, 0), truncated(env_count, 0)
+    {
+        envs.reserve(env_count);
+        for (uint32_t i = 0; i < env_count; ++i) envs.emplace_back(seed + i, time_diff, max_steps);
+        reset();
+    }
+
+    void VecEnv::reset()
+    {
+        for (uint32_t i = 0; i < envs.size(); ++i)
+        {
+            envs[i].reset();
+            store_state(i);
+        }
+        std::fill(rewards.begin(), rewards.end(), 0.0f);
+        std::fill(dones.begin(), dones.end(), 0);
+        std::fill(truncated.begin(), truncated.end(), 0);
+    }
+
+    void VecEnv::reset_done()
+    {
+        for (uint32_t i = 0; i < envs.size(); ++i)
+        {
+            if (!dones[i]) continue;
+            envs[i].reset();
+            store_state(i);
+            rewards[i] = 0.0f;
+            dones[i] = 0;
+            truncated[i] = 0;
+        }
+    }
+
+    void VecEnv::step(const std::vector<MoveActionFlags::type>& actions)
+    {
+        for (uint32_t i = 0; i < envs.size(); ++i)
+        {
+            if (dones[i])
+            {
+                rewards[i] = 0.0f;
+                continue;
+            }
+            envs[i].step(actions[i]);
+            rewards[i] = envs[i].get_reward();
+            dones[i] = envs[i].is_done();
+            truncated[i] = envs[i].is_truncated();
+            store_state(i);
+        }
+    }
+
+    uint32_t VecEnv::get_env_count() const
+    {
+        return envs.size();
+    }
+
+    const std::vector<float>& VecEnv::get_states() const
+    {
+        return states;
+    }
+
+    const std::vector<float>& VecEnv::get_rewards() const
+    {
+        return rewards;
+    }
+
+    const std::vector<uint8_t>& VecEnv::get_dones() const
+    {
+        return dones;
+    }
+
+    const std::vector<uint8_t>& VecEnv::get_truncated() const
+    {
+        return truncated;
+    }
+
+    bool VecEnv::is_all_done() const
+    {
+        return std::all_of(dones.begin(), dones.end(), [](uint8_t done){ return done != 0; });
+    }
+
+    float VecEnv::get_distance(uint32_t env_idx) const
+    {
+        return envs[env_idx].get_distance();
+    }
+
+    void VecEnv::store_state(uint32_t env_idx)
+    {
+        const std::vector<float>& state = envs[env_idx].get_state();
+        for (uint32_t i = 0; i < TunnelEnv::state_size; ++i) states[i * envs.size() + env_idx] = state[i];
+    }
+} // namespace ve
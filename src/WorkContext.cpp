@@ -3,7 +3,7 @@
 
 namespace ve
 {
-WorkContext::WorkContext(const VulkanMainContext& vmc, VulkanCommandContext& vcc) : vmc(vmc), vcc(vcc), storage(vmc, vcc), swapchain(vmc, vcc, storage), scene(vmc, vcc, storage), ui(vmc, swapchain.get_render_pass(), frames_in_flight), lighting(vmc, storage)
+WorkContext::WorkContext(const VulkanMainContext& vmc, VulkanCommandContext& vcc) : vmc(vmc), vcc(vcc), storage(vmc, vcc), swapchain(vmc, vcc, storage), scene(vmc, vcc, storage), ui(vmc, swapchain.get_render_pass(), frames_in_flight), lighting(vmc, storage), readback_ring(vmc, readback_ring_frame_size)
 {
     vcc.add_graphics_buffers(frames_in_flight * 3);
     vcc.add_compute_buffers(frames_in_flight * 3);
@@ -28,6 +28,7 @@ void WorkContext::self_destruct()
     syncs.clear();
     for (auto& timer : timers) timer.self_destruct();
     timers.clear();
+    readback_ring.self_destruct();
     ui.self_destruct();
     scene.self_destruct();
     swapchain.self_destruct(true);
@@ -38,8 +39,10 @@ void WorkContext::self_destruct()
 void WorkContext::reload_shaders()
 {
     vmc.logical_device.get().waitIdle();
-    scene.reload_shaders(swapchain.get_deferred_render_pass());
+    PipelineBuilder pipeline_builder;
+    scene.reload_shaders(swapchain.get_deferred_render_pass(), pipeline_builder);
     // lighting.reload_shaders();
+    pipeline_builder.build();
 }
 
 void WorkContext::load_scene(const std::string& filename)
@@ -51,15 +54,19 @@ void WorkContext::load_scene(const std::string& filename)
         scene.self_destruct();
     }
     scene.load(std::string("../assets/scenes/") + filename);
-    scene.construct(swapchain.get_deferred_render_pass());
+    // all pipelines of the scene and the lighting are created together after everything is described
+    PipelineBuilder pipeline_builder;
+    scene.construct(swapchain.get_deferred_render_pass(), pipeline_builder);
+    lighting.construct(scene.get_light_count(), swapchain, pipeline_builder);
+    pipeline_builder.build();
     spdlog::info("Loading scene took: {} ms", (timer.elapsed()));
-    lighting.construct(scene.get_light_count(), swapchain);
+    vmc.buffer_pools.log_statistics();
 }
 
-void WorkContext::restart()
+void WorkContext::restart(uint32_t seed)
 {
     vmc.logical_device.get().waitIdle();
-    scene.restart();
+    scene.restart(seed);
 }
 
 void WorkContext::draw_frame(GameState& gs)
@@ -68,6 +75,7 @@ void WorkContext::draw_frame(GameState& gs)
 
     syncs[gs.game_data.current_frame].wait_for_fence(Synchronization::F_RENDER_FINISHED);
     syncs[gs.game_data.current_frame].reset_fence(Synchronization::F_RENDER_FINISHED);
+    readback_ring.begin_frame(gs.game_data.current_frame);
     vk::ResultValue<uint32_t> image_idx = vmc.logical_device.get().acquireNextImageKHR(swapchain.get(), uint64_t(-1), syncs[gs.game_data.current_frame].get_semaphore(Synchronization::S_IMAGE_AVAILABLE));
     VE_CHECK(image_idx.result, "Failed to acquire next image!");
     for (uint32_t i = 0; i < DeviceTimer::TIMER_COUNT && gs.game_data.total_frames >= timers.size(); ++i)
@@ -91,14 +99,16 @@ vk::Extent2D WorkContext::recreate_swapchain()
     swapchain.self_destruct(false);
     swapchain.construct();
     lighting.self_destruct();
-    lighting.construct(scene.get_light_count(), swapchain);
+    PipelineBuilder pipeline_builder;
+    lighting.construct(scene.get_light_count(), swapchain, pipeline_builder);
+    pipeline_builder.build();
     return swapchain.get_extent();
 }
 
 void WorkContext::record_graphics_command_buffer(uint32_t image_idx, GameState& gs)
 {
     vk::CommandBuffer& compute_cb = vcc.begin(vcc.compute_cb[gs.game_data.current_frame + frames_in_flight * 2]);
-    scene.update_game_state(compute_cb, gs, timers[gs.game_data.current_frame]);
+    scene.update_game_state(compute_cb, gs, timers[gs.game_data.current_frame], readback_ring);
     compute_cb.end();
 
     vk::CommandBuffer& cb = vcc.begin(vcc.graphics_cb[gs.game_data.current_frame]);
@@ -180,9 +190,19 @@ void WorkContext::record_graphics_command_buffer(uint32_t image_idx, GameState&
 void WorkContext::submit(uint32_t image_idx, GameState& gs)
 {
     std::array<vk::CommandBuffer, 3> compute_cbs{vcc.compute_cb[gs.game_data.current_frame], vcc.compute_cb[gs.game_data.current_frame + frames_in_flight], vcc.compute_cb[gs.game_data.current_frame + frames_in_flight * 2]};
+    // uploads recorded since the last frame need to be finished before the frame uses them, the graphics submission waits on the compute submission
+    const uint64_t upload_value = vcc.upload_context.flush();
+    const vk::PipelineStageFlags upload_wait_stage = vk::PipelineStageFlagBits::eAllCommands;
+    vk::TimelineSemaphoreSubmitInfo compute_tssi{};
+    compute_tssi.sType = vk::StructureType::eTimelineSemaphoreSubmitInfo;
+    compute_tssi.waitSemaphoreValueCount = 1;
+    compute_tssi.pWaitSemaphoreValues = &upload_value;
     vk::SubmitInfo compute_si{};
     compute_si.sType = vk::StructureType::eSubmitInfo;
-    compute_si.waitSemaphoreCount = 0;
+    compute_si.pNext = &compute_tssi;
+    compute_si.waitSemaphoreCount = 1;
+    compute_si.pWaitSemaphores = &vcc.upload_context.get_semaphore();
+    compute_si.pWaitDstStageMask = &upload_wait_stage;
     compute_si.commandBufferCount = compute_cbs.size();
     compute_si.pCommandBuffers = compute_cbs.data();
     compute_si.signalSemaphoreCount = 1;
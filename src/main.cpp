@@ -6,6 +6,9 @@
 
 #include "vk/Timer.hpp"
 #include "MainContext.hpp"
+#include "HeadlessContext.hpp"
+#include "ActorLearner.hpp"
+#include "Evaluator.hpp"
 
 int parse_args(int argc, char** argv, boost::program_options::variables_map& vm)
 {
@@ -16,6 +19,18 @@ int parse_args(int argc, char** argv, boost::program_options::variables_map& vm)
         ("nn_file", bpo::value<std::string>(), "Load neural network checkpoint from given file and initialize the agent with this network")
         ("train_mode,T", "Train agent")
         ("disable_rendering,R", "Do not render the game to enable quicker training iterations")
+        ("headless,H", "Train agent in a cpu only tunnel environment without creating a window or vulkan context")
+        ("episodes", bpo::value<uint32_t>()->default_value(1000), "Number of episodes to train in headless mode or to evaluate")
+        ("envs", bpo::value<uint32_t>()->default_value(1), "Number of tunnel environments that are simulated in lockstep in headless mode")
+        ("actors", bpo::value<uint32_t>()->default_value(0), "Number of actor threads that collect episodes for a separate learner in headless mode")
+        ("ppo", "Train agent with PPO instead of REINFORCE in headless mode (not supported with actors)")
+        ("seed", bpo::value<uint32_t>()->default_value(0), "Seed of the tunnel generation; restarts and evaluation episodes use consecutive seeds")
+        ("record", bpo::value<std::string>(), "Record the input of every frame to the given replay file")
+        ("replay", bpo::value<std::string>(), "Play back the input of the given replay file")
+        ("evaluate,E", "Play seeded episodes with the agent of nn_file (required) in cpu only tunnel environments and write statistics to the report file")
+        ("threads", bpo::value<uint32_t>()->default_value(0), "Number of threads used for evaluation (0 uses all hardware threads)")
+        ("max_steps", bpo::value<uint32_t>()->default_value(3600), "Maximum number of steps of an evaluation episode")
+        ("report", bpo::value<std::string>()->default_value("evaluation.json"), "File the evaluation report is written to")
     ;
     bpo::store(bpo::parse_command_line(argc, argv, desc), vm);
     bpo::notify(vm);
@@ -36,6 +51,11 @@ int main(int argc, char** argv)
     if (vm.count("nn_file")) nn_file = vm["nn_file"].as<std::string>();
     bool train_mode = vm.count("train_mode");
     bool disable_rendering = vm.count("disable_rendering");
+    bool headless = vm.count("headless");
+    std::string record_file = "";
+    if (vm.count("record")) record_file = vm["record"].as<std::string>();
+    std::string replay_file = "";
+    if (vm.count("replay")) replay_file = vm["replay"].as<std::string>();
 
     std::vector<spdlog::sink_ptr> sinks;
     sinks.push_back(std::make_shared<spdlog::sinks::stdout_sink_st>());
@@ -45,8 +65,36 @@ int main(int argc, char** argv)
     spdlog::set_level(spdlog::level::debug);
     spdlog::set_pattern("[%Y-%m-%d %T.%e] [%L] %v");
     spdlog::info("Starting");
+    if (vm.count("evaluate"))
+    {
+        if (nn_file == "")
+        {
+            spdlog::error("Evaluation needs the checkpoint of the agent, pass it with --nn_file");
+            return 1;
+        }
+        Evaluator evaluator(nn_file, vm["episodes"].as<uint32_t>(), vm["threads"].as<uint32_t>(), vm["seed"].as<uint32_t>(), vm["max_steps"].as<uint32_t>());
+        evaluator.run(vm["report"].as<std::string>());
+        return 0;
+    }
+    if (headless && vm["actors"].as<uint32_t>() > 0)
+    {
+        if (vm.count("ppo"))
+        {
+            spdlog::error("PPO is not supported with actor threads, use --ppo without --actors");
+            return 1;
+        }
+        ActorLearner al(nn_file, vm["episodes"].as<uint32_t>(), vm["actors"].as<uint32_t>());
+        al.run();
+        return 0;
+    }
+    if (headless)
+    {
+        HeadlessContext hc(nn_file, vm["episodes"].as<uint32_t>(), vm["envs"].as<uint32_t>(), vm.count("ppo"));
+        hc.run();
+        return 0;
+    }
     ve::HostTimer t;
-    MainContext mc(nn_file, train_mode, disable_rendering);
+    MainContext mc(nn_file, train_mode, disable_rendering, vm["seed"].as<uint32_t>(), record_file, replay_file);
     spdlog::info("Setup took: {} ms", t.elapsed());
     mc.run();
     return 0;
@@ -0,0 +1,62 @@
+#include "vk/BufferPools.hpp"
+
+#include "ve_log.hpp"
+
+namespace ve
+{
+    void BufferPools::construct(VmaAllocator va)
+    {
+        this->va = va;
+        host_pool = create_pool("small_host_buffers", vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst, VMA_MEMORY_USAGE_AUTO_PREFER_HOST, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+        device_pool = create_pool("small_device_buffers", vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE, 0);
+    }
+
+    void BufferPools::self_destruct()
+    {
+        vmaDestroyPool(va, host_pool);
+        vmaDestroyPool(va, device_pool);
+    }
+
+    VmaPool BufferPools::get_pool(vk::DeviceSize byte_size, bool device_local) const
+    {
+        if (byte_size > small_buffer_max_byte_size) return VK_NULL_HANDLE;
+        return device_local ? device_pool : host_pool;
+    }
+
+    void BufferPools::log_statistics() const
+    {
+        log_pool_statistics("small_host_buffers", host_pool);
+        log_pool_statistics("small_device_buffers", device_pool);
+    }
+
+    VmaPool BufferPools::create_pool(const char* name, vk::BufferUsageFlags usage_flags, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags vma_flags)
+    {
+        // the memory type is chosen for a typical buffer of the pool, buffers that do not fit it fall back to the default pools
+        vk::BufferCreateInfo bci{};
+        bci.sType = vk::StructureType::eBufferCreateInfo;
+        bci.size = small_buffer_max_byte_size;
+        bci.usage = usage_flags;
+        bci.sharingMode = vk::SharingMode::eExclusive;
+        VmaAllocationCreateInfo vaci{};
+        vaci.usage = memory_usage;
+        vaci.flags = vma_flags;
+        uint32_t memory_type_idx;
+        VE_CHECK(vk::Result(vmaFindMemoryTypeIndexForBufferInfo(va, (VkBufferCreateInfo*) (&bci), &vaci, &memory_type_idx)), "Failed to find memory type for buffer pool!");
+
+        VmaPoolCreateInfo vpci{};
+        vpci.memoryTypeIndex = memory_type_idx;
+        vpci.blockSize = small_buffer_pool_block_size;
+        VmaPool pool;
+        VE_CHECK(vk::Result(vmaCreatePool(va, &vpci, &pool)), "Failed to create buffer pool!");
+        vmaSetPoolName(va, pool, name);
+        spdlog::debug("Created buffer pool \"{}\" with memory type {}", name, memory_type_idx);
+        return pool;
+    }
+
+    void BufferPools::log_pool_statistics(const char* name, VmaPool pool) const
+    {
+        VmaStatistics stats;
+        vmaGetPoolStatistics(va, pool, &stats);
+        spdlog::debug("Buffer pool \"{}\": {} allocations with {} bytes in {} blocks with {} bytes", name, stats.allocationCount, stats.allocationBytes, stats.blockCount, stats.blockBytes);
+    }
+} // namespace ve
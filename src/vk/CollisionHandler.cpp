@@ -6,7 +6,7 @@
 
 namespace ve
 {
-    CollisionHandler::CollisionHandler(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage) : vmc(vmc), vcc(vcc), storage(storage), compute_dsh(vmc), compute_pipeline(vmc), render_pipeline(vmc)
+    CollisionHandler::CollisionHandler(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage) : vmc(vmc), vcc(vcc), storage(storage), compute_dsh(vmc), broadphase_pipeline(vmc), compute_pipeline(vmc), render_pipeline(vmc)
     {}
 
     void CollisionHandler::create_buffers(const std::vector<Vertex>& vertices, uint32_t scene_player_start_idx, uint32_t scene_player_idx_count)
@@ -22,10 +22,11 @@ namespace ve
         }
         bb_buffer = storage.add_named_buffer(std::string("player_bb"), sizeof(bb), vk::BufferUsageFlagBits::eStorageBuffer, true, vmc.queue_family_indices.compute);
         storage.get_buffer(bb_buffer).update_data(bb);
-        return_buffers.push_back(storage.add_named_buffer(std::string("collision_return_0"), sizeof(CollisionResults), vk::BufferUsageFlagBits::eStorageBuffer, false, vmc.queue_family_indices.compute));
-        return_buffers.push_back(storage.add_named_buffer(std::string("collision_return_1"), sizeof(CollisionResults), vk::BufferUsageFlagBits::eStorageBuffer, false, vmc.queue_family_indices.compute));
-        reset_shader_return_values(0);
-        reset_shader_return_values(1);
+        return_buffers.push_back(storage.add_named_buffer(std::string("collision_return_0"), sizeof(CollisionResults), vk::BufferUsageFlagBits::eStorageBuffer, true, vmc.queue_family_indices.compute));
+        return_buffers.push_back(storage.add_named_buffer(std::string("collision_return_1"), sizeof(CollisionResults), vk::BufferUsageFlagBits::eStorageBuffer, true, vmc.queue_family_indices.compute));
+        broadphase_buffers.push_back(storage.add_named_buffer(std::string("collision_broadphase_0"), sizeof(Broadphase), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer, true, vmc.queue_family_indices.compute));
+        broadphase_buffers.push_back(storage.add_named_buffer(std::string("collision_broadphase_1"), sizeof(Broadphase), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer, true, vmc.queue_family_indices.compute));
+        reset_all_shader_return_values();
         std::vector<DebugVertex> bb_vertices(36);
         DebugVertex v0{.pos = glm::vec3(bb.min), .color = glm::vec4(1.0f, 0.0f, 1.0f, 1.0f)};
         DebugVertex v1{.pos = glm::vec3(bb.max.x, bb.min.y, bb.min.z), .color = glm::vec4(1.0f, 0.0f, 1.0f, 1.0f)};
@@ -74,7 +75,7 @@ namespace ve
         vertex_buffer = storage.add_named_buffer(std::string("player_aabb_vertices"), bb_vertices, vk::BufferUsageFlagBits::eVertexBuffer, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.graphics);
     }
 
-    void CollisionHandler::construct(const RenderPass& render_pass)
+    void CollisionHandler::construct(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
         compute_dsh.add_binding(0, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
@@ -83,6 +84,9 @@ namespace ve
         compute_dsh.add_binding(4, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(5, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(6, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eCompute);
+        compute_dsh.add_binding(7, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
+        compute_dsh.add_binding(8, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
+        compute_dsh.add_binding(9, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(90, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(99, vk::DescriptorType::eAccelerationStructureKHR, vk::ShaderStageFlagBits::eCompute);
         for (uint32_t i = 0; i < frames_in_flight; ++i)
@@ -90,32 +94,36 @@ namespace ve
             compute_dsh.new_set();
             compute_dsh.add_descriptor(0, storage.get_buffer(bb_buffer));
             compute_dsh.add_descriptor(1, storage.get_buffer(return_buffers[i]));
-            compute_dsh.add_descriptor(2, storage.get_buffer_by_name("tunnel_indices"));
-            compute_dsh.add_descriptor(3, storage.get_buffer_by_name("tunnel_vertices"));
+            compute_dsh.add_descriptor(2, storage.get_buffer_by_name("tunnel_collision_indices"));
+            compute_dsh.add_descriptor(3, storage.get_buffer_by_name("tunnel_collision_vertices"));
             compute_dsh.add_descriptor(4, storage.get_buffer_by_name("indices"));
             compute_dsh.add_descriptor(5, storage.get_buffer_by_name("vertices"));
             compute_dsh.add_descriptor(6, storage.get_buffer_by_name("bb_mm_" + std::to_string(i)));
+            compute_dsh.add_descriptor(7, storage.get_buffer_by_name("tunnel_bezier_points"));
+            compute_dsh.add_descriptor(8, storage.get_buffer_by_name("tunnel_ring_radii"));
+            compute_dsh.add_descriptor(9, storage.get_buffer(broadphase_buffers[i]));
             compute_dsh.add_descriptor(90, storage.get_buffer_by_name("frame_data_" + std::to_string(i)));
             compute_dsh.add_descriptor(99, storage.get_buffer_by_name("tlas_" + std::to_string(i)));
         }
         compute_dsh.construct();
-        construct_pipelines(render_pass);
+        construct_pipelines(render_pass, pipeline_builder);
     }
 
-    void CollisionHandler::reload_shaders(const RenderPass& render_pass)
+    void CollisionHandler::reload_shaders(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
         self_destruct(false);
-        construct_pipelines(render_pass);
+        construct_pipelines(render_pass, pipeline_builder);
     }
 
-    void CollisionHandler::construct_pipelines(const RenderPass& render_pass)
+    void CollisionHandler::construct_pipelines(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
         std::vector<ShaderInfo> shader_infos(2);
         shader_infos[0] = ShaderInfo{"debug.vert", vk::ShaderStageFlagBits::eVertex};
         shader_infos[1] = ShaderInfo{"debug.frag", vk::ShaderStageFlagBits::eFragment};
-        render_pipeline.construct(render_pass, std::nullopt, shader_infos, vk::PolygonMode::eLine, DebugVertex::get_binding_descriptions(), DebugVertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(DebugPushConstants))});
+        render_pipeline.describe(render_pass, std::nullopt, shader_infos, vk::PolygonMode::eLine, DebugVertex::get_binding_descriptions(), DebugVertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(DebugPushConstants))});
+        pipeline_builder.add(render_pipeline);
 
-        std::array<vk::SpecializationMapEntry, 8> compute_entries;
+        std::array<vk::SpecializationMapEntry, 11> compute_entries;
         compute_entries[0] = vk::SpecializationMapEntry(0, 0, sizeof(uint32_t));
         compute_entries[1] = vk::SpecializationMapEntry(1, sizeof(uint32_t), sizeof(uint32_t));
         compute_entries[2] = vk::SpecializationMapEntry(2, sizeof(uint32_t) * 2, sizeof(uint32_t));
@@ -124,22 +132,31 @@ namespace ve
         compute_entries[5] = vk::SpecializationMapEntry(5, sizeof(uint32_t) * 5, sizeof(uint32_t));
         compute_entries[6] = vk::SpecializationMapEntry(6, sizeof(uint32_t) * 6, sizeof(uint32_t));
         compute_entries[7] = vk::SpecializationMapEntry(7, sizeof(uint32_t) * 7, sizeof(uint32_t));
-        std::array<uint32_t, 8> compute_entries_data{segment_count, samples_per_segment, vertices_per_sample, indices_per_segment, player_start_idx, player_idx_count, player_local_segment_position, distance_directions_count};
+        compute_entries[8] = vk::SpecializationMapEntry(8, sizeof(uint32_t) * 8, sizeof(uint32_t));
+        compute_entries[9] = vk::SpecializationMapEntry(9, sizeof(uint32_t) * 9, sizeof(uint32_t));
+        compute_entries[10] = vk::SpecializationMapEntry(10, sizeof(uint32_t) * 10, sizeof(uint32_t));
+        std::array<uint32_t, 11> compute_entries_data{segment_count, samples_per_segment, vertices_per_sample, indices_per_segment, player_start_idx, player_idx_count, player_local_segment_position, distance_directions_count, collision_samples_per_segment, collision_vertices_per_sample, collision_indices_per_segment};
         vk::SpecializationInfo compute_spec_info(compute_entries.size(), compute_entries.data(), compute_entries_data.size() * sizeof(uint32_t), compute_entries_data.data());
-        compute_pipeline.construct(compute_dsh.get_layouts()[0], ShaderInfo{"player_tunnel_collision.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, 0);
+        broadphase_pipeline.describe(compute_dsh.get_layouts()[0], ShaderInfo{"player_tunnel_broadphase.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, sizeof(PlayerCollisionPushConstants));
+        pipeline_builder.add(broadphase_pipeline);
+        compute_pipeline.describe(compute_dsh.get_layouts()[0], ShaderInfo{"player_tunnel_collision.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, sizeof(PlayerCollisionPushConstants));
+        pipeline_builder.add(compute_pipeline);
     }
 
     void CollisionHandler::self_destruct(bool full)
     {
         render_pipeline.self_destruct();
+        broadphase_pipeline.self_destruct();
         compute_pipeline.self_destruct();
         if (full)
         {
             compute_dsh.self_destruct();
-            storage.get_buffer(bb_buffer).self_destruct();
-            for (auto& b : return_buffers) storage.get_buffer(b).self_destruct();
+            storage.destroy_buffer(bb_buffer);
+            for (auto& b : return_buffers) storage.destroy_buffer(b);
             return_buffers.clear();
-            storage.get_buffer(vertex_buffer).self_destruct();
+            for (auto& b : broadphase_buffers) storage.destroy_buffer(b);
+            broadphase_buffers.clear();
+            storage.destroy_buffer(vertex_buffer);
         }
     }
 
@@ -153,30 +170,59 @@ namespace ve
         cb.draw(36, 1, 0, 0);
     }
 
-    void CollisionHandler::compute(uint32_t current_frame, DeviceTimer& timer)
+    void CollisionHandler::compute(uint32_t current_frame, DeviceTimer& timer, ReadbackRing& readback_ring, uint32_t first_segment_uid)
     {
+        // the fence of the frame has been waited for, so the readback of the last computation of this frame is complete
+        if (readbacks[current_frame].is_ready()) collision_results[current_frame] = readbacks[current_frame].get<CollisionResults>();
+
         vk::CommandBuffer& cb = vcc.begin(vcc.compute_cb[current_frame + frames_in_flight]);
         timer.reset(cb, {DeviceTimer::COMPUTE_PLAYER_TUNNEL_COLLISION});
         timer.start(cb, DeviceTimer::COMPUTE_PLAYER_TUNNEL_COLLISION, vk::PipelineStageFlagBits::eAllCommands);
+        Buffer& return_buffer = storage.get_buffer(return_buffers[current_frame]);
+        if (reset_pending[current_frame])
+        {
+            cb.fillBuffer(return_buffer.get(), 0, sizeof(CollisionResults::collision_detected), 0);
+            vk::BufferMemoryBarrier reset_memory_barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite, vmc.queue_family_indices.compute, vmc.queue_family_indices.compute, return_buffer.get(), 0, return_buffer.get_byte_size());
+            cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlagBits::eDeviceGroup, {}, {reset_memory_barrier}, {});
+            reset_pending[current_frame] = false;
+        }
+        PlayerCollisionPushConstants pcpc{.first_segment_uid = first_segment_uid};
+        cb.bindPipeline(vk::PipelineBindPoint::eCompute, broadphase_pipeline.get());
+        cb.bindDescriptorSets(vk::PipelineBindPoint::eCompute, broadphase_pipeline.get_layout(), 0, compute_dsh.get_sets()[current_frame], {});
+        cb.pushConstants(broadphase_pipeline.get_layout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(PlayerCollisionPushConstants), &pcpc);
+        cb.dispatch(1, 1, 1);
+        Buffer& broadphase_buffer = storage.get_buffer(broadphase_buffers[current_frame]);
+        vk::BufferMemoryBarrier buffer_memory_barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead, vmc.queue_family_indices.compute, vmc.queue_family_indices.compute, broadphase_buffer.get(), 0, broadphase_buffer.get_byte_size());
+        cb.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlagBits::eDeviceGroup, {}, {buffer_memory_barrier}, {});
         cb.bindPipeline(vk::PipelineBindPoint::eCompute, compute_pipeline.get());
-        cb.bindDescriptorSets(vk::PipelineBindPoint::eCompute, compute_pipeline.get_layout(), 0, compute_dsh.get_sets()[current_frame], {});
-        cb.dispatch(((indices_per_segment * 3) / 3 + 31 + distance_directions_count) / 32, 1, 1);
+        cb.pushConstants(compute_pipeline.get_layout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(PlayerCollisionPushConstants), &pcpc);
+        cb.dispatchIndirect(broadphase_buffer.get(), 0);
         timer.stop(cb, DeviceTimer::COMPUTE_PLAYER_TUNNEL_COLLISION, vk::PipelineStageFlagBits::eComputeShader);
+        vk::BufferMemoryBarrier return_memory_barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead, vmc.queue_family_indices.compute, vmc.queue_family_indices.compute, return_buffer.get(), 0, return_buffer.get_byte_size());
+        cb.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlagBits::eDeviceGroup, {}, {return_memory_barrier}, {});
+        readbacks[current_frame] = return_buffer.obtain_first_element_async<CollisionResults>(cb, readback_ring, current_frame);
         cb.end();
     }
 
     CollisionResults CollisionHandler::get_collision_results(uint32_t frame_idx)
     {
-        return storage.get_buffer(return_buffers[frame_idx]).obtain_first_element<CollisionResults>();
+        return collision_results[frame_idx];
     }
 
     void CollisionHandler::reset_shader_return_values(uint32_t frame_idx)
     {
-        storage.get_buffer(return_buffers[frame_idx]).erase_bytes(sizeof(CollisionResults::collision_detected));
+        reset_pending[frame_idx] = true;
+        collision_results[frame_idx].collision_detected = 0;
     }
 
     void CollisionHandler::reset_all_shader_return_values()
     {
-        for (auto b : return_buffers) storage.get_buffer(b).erase_bytes(sizeof(CollisionResults::collision_detected));
+        for (uint32_t i = 0; i < frames_in_flight; ++i)
+        {
+            reset_shader_return_values(i);
+            // results that are still in flight were computed before the reset
+            readbacks[i] = ReadbackHandle();
+            collision_results[i] = CollisionResults();
+        }
     }
 } // namespace ve
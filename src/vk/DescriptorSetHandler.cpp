@@ -26,13 +26,18 @@ namespace ve
     }
 
     void DescriptorSetHandler::add_descriptor(uint32_t binding, const Buffer& buffer)
+    {
+        add_descriptor(binding, buffer, buffer.get_byte_size());
+    }
+
+    void DescriptorSetHandler::add_descriptor(uint32_t binding, const Buffer& buffer, vk::DeviceSize range)
     {
         // add buffer descriptor to current descriptor set
         // every set needs to be build one after another
         vk::DescriptorBufferInfo dbi{};
         dbi.buffer = buffer.get();
         dbi.offset = 0;
-        dbi.range = buffer.get_byte_size();
+        dbi.range = range;
         descriptor_sets.back().push_back(Descriptor(binding, dbi, {}, buffer.pNext));
     }
 
@@ -6,7 +6,7 @@
 
 namespace ve
 {
-    Fireflies::Fireflies(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage) : render_dsh(vmc), compute_dsh(vmc), vmc(vmc), vcc(vcc), storage(storage), render_pipeline(vmc), move_compute_pipeline(vmc), tunnel_collision_compute_pipeline(vmc)
+    Fireflies::Fireflies(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage, UploadArena& upload_arena) : render_dsh(vmc), compute_dsh(vmc), vmc(vmc), vcc(vcc), storage(storage), upload_arena(upload_arena), render_pipeline(vmc), move_compute_pipeline(vmc), tunnel_collision_compute_pipeline(vmc)
     {}
 
     void Fireflies::self_destruct(bool full)
@@ -20,8 +20,6 @@ namespace ve
             compute_dsh.self_destruct();
             for (auto i : vertex_buffers) storage.destroy_buffer(i);
             vertex_buffers.clear();
-            for (auto i : model_render_data_buffers) storage.destroy_buffer(i);
-            model_render_data_buffers.clear();
         }
     }
 
@@ -32,9 +30,9 @@ namespace ve
         vertex_buffers.push_back(storage.add_named_buffer(std::string("firefly_vertices_1"), vertices, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.graphics, vmc.queue_family_indices.compute));
     }
 
-    void Fireflies::construct(const RenderPass& render_pass)
+    void Fireflies::construct(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
-        render_dsh.add_binding(0, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eVertex);
+        render_dsh.add_binding(0, vk::DescriptorType::eUniformBufferDynamic, vk::ShaderStageFlagBits::eVertex);
         compute_dsh.add_binding(0, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(3, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
@@ -44,21 +42,19 @@ namespace ve
         compute_dsh.add_binding(7, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(90, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eCompute);
 
-        // add one uniform buffer and descriptor set for each frame as the uniform buffer is changed in every frame
+        // one descriptor set for each frame, the model render data is placed in the upload arena of the frame every frame
         for (uint32_t i = 0; i < frames_in_flight; ++i)
         {
-            model_render_data_buffers.push_back(storage.add_buffer(std::vector<ModelRenderData>{mrd}, vk::BufferUsageFlagBits::eUniformBuffer, false, vmc.queue_family_indices.transfer, vmc.queue_family_indices.graphics));
-
             render_dsh.new_set();
-            render_dsh.add_descriptor(0, storage.get_buffer(model_render_data_buffers.back()));
+            render_dsh.add_descriptor(0, upload_arena.get_buffer(i), sizeof(ModelRenderData));
 
             // ping-pong with firefly buffers to avoid data races
             compute_dsh.new_set();
             compute_dsh.add_descriptor(0, storage.get_buffer(vertex_buffers[1 - i]));
             compute_dsh.add_descriptor(1, storage.get_buffer(vertex_buffers[i]));
             compute_dsh.add_descriptor(3, storage.get_buffer_by_name("tunnel_bezier_points"));
-            compute_dsh.add_descriptor(4, storage.get_buffer_by_name("tunnel_indices"));
-            compute_dsh.add_descriptor(5, storage.get_buffer_by_name("tunnel_vertices"));
+            compute_dsh.add_descriptor(4, storage.get_buffer_by_name("tunnel_collision_indices"));
+            compute_dsh.add_descriptor(5, storage.get_buffer_by_name("tunnel_collision_vertices"));
             compute_dsh.add_descriptor(6, storage.get_buffer_by_name("player_bb"));
             compute_dsh.add_descriptor(7, storage.get_buffer_by_name("bb_mm_" + std::to_string(i)));
             compute_dsh.add_descriptor(90, storage.get_buffer_by_name("frame_data_" + std::to_string(i)));
@@ -66,10 +62,10 @@ namespace ve
         render_dsh.construct();
         compute_dsh.construct();
 
-        construct_pipelines(render_pass);
+        construct_pipelines(render_pass, pipeline_builder);
     }
 
-    void Fireflies::construct_pipelines(const RenderPass& render_pass)
+    void Fireflies::construct_pipelines(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
         std::array<vk::SpecializationMapEntry, 1> vertex_entries;
         vertex_entries[0] = vk::SpecializationMapEntry(0, 0, sizeof(uint32_t));
@@ -79,26 +75,33 @@ namespace ve
         std::vector<ShaderInfo> shader_infos(2);
         shader_infos[0] = ShaderInfo{"fireflies.vert", vk::ShaderStageFlagBits::eVertex, vertex_spec_info};
         shader_infos[1] = ShaderInfo{"fireflies.frag", vk::ShaderStageFlagBits::eFragment};
-        render_pipeline.construct(render_pass, render_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::ePoint, FireflyVertex::get_binding_descriptions(), FireflyVertex::get_attribute_descriptions(), vk::PrimitiveTopology::ePointList, {});
+        render_pipeline.describe(render_pass, render_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::ePoint, FireflyVertex::get_binding_descriptions(), FireflyVertex::get_attribute_descriptions(), vk::PrimitiveTopology::ePointList, {});
+        pipeline_builder.add(render_pipeline);
 
-        std::array<vk::SpecializationMapEntry, 6> compute_entries;
+        std::array<vk::SpecializationMapEntry, 9> compute_entries;
         compute_entries[0] = vk::SpecializationMapEntry(0, 0, sizeof(uint32_t));
         compute_entries[1] = vk::SpecializationMapEntry(1, sizeof(uint32_t), sizeof(uint32_t));
         compute_entries[2] = vk::SpecializationMapEntry(2, sizeof(uint32_t) * 2, sizeof(uint32_t));
         compute_entries[3] = vk::SpecializationMapEntry(3, sizeof(uint32_t) * 3, sizeof(uint32_t));
         compute_entries[4] = vk::SpecializationMapEntry(4, sizeof(uint32_t) * 4, sizeof(uint32_t));
         compute_entries[5] = vk::SpecializationMapEntry(5, sizeof(uint32_t) * 5, sizeof(uint32_t));
-        std::array<uint32_t, 6> compute_entries_data{segment_count, samples_per_segment, vertices_per_sample, fireflies_per_segment, firefly_count, indices_per_segment};
+        compute_entries[6] = vk::SpecializationMapEntry(6, sizeof(uint32_t) * 6, sizeof(uint32_t));
+        compute_entries[7] = vk::SpecializationMapEntry(7, sizeof(uint32_t) * 7, sizeof(uint32_t));
+        compute_entries[8] = vk::SpecializationMapEntry(8, sizeof(uint32_t) * 8, sizeof(uint32_t));
+        std::array<uint32_t, 9> compute_entries_data{segment_count, samples_per_segment, vertices_per_sample, fireflies_per_segment, firefly_count, indices_per_segment, collision_samples_per_segment, collision_vertices_per_sample, collision_indices_per_segment};
         vk::SpecializationInfo compute_spec_info(compute_entries.size(), compute_entries.data(), compute_entries_data.size() * sizeof(uint32_t), compute_entries_data.data());
 
-        move_compute_pipeline.construct(compute_dsh.get_layouts()[0], ShaderInfo{"fireflies_move.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, sizeof(FireflyMovePushConstants));
-        tunnel_collision_compute_pipeline.construct(compute_dsh.get_layouts()[0], ShaderInfo{"fireflies_tunnel_collision.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, sizeof(FireflyMovePushConstants));
+        move_compute_pipeline.describe(compute_dsh.get_layouts()[0], ShaderInfo{"fireflies_move.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, sizeof(FireflyMovePushConstants));
+
+        pipeline_builder.add(move_compute_pipeline);
+        tunnel_collision_compute_pipeline.describe(compute_dsh.get_layouts()[0], ShaderInfo{"fireflies_tunnel_collision.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, sizeof(FireflyMovePushConstants));
+        pipeline_builder.add(tunnel_collision_compute_pipeline);
     }
 
-    void Fireflies::reload_shaders(const RenderPass& render_pass)
+    void Fireflies::reload_shaders(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
         self_destruct(false);
-        construct_pipelines(render_pass);
+        construct_pipelines(render_pass, pipeline_builder);
     }
 
     void Fireflies::draw(vk::CommandBuffer& cb, GameState& gs)
@@ -107,9 +110,9 @@ namespace ve
         mrd.prev_MVP = mrd.MVP;
         mrd.MVP = gs.cam.getVP();
         mrd.M = gs.cam.getV();
-        storage.get_buffer(model_render_data_buffers[gs.game_data.current_frame]).update_data(std::vector<ModelRenderData>{mrd});
+        const uint32_t mrd_offset = upload_arena.upload(gs.game_data.current_frame, mrd);
         cb.bindPipeline(vk::PipelineBindPoint::eGraphics, render_pipeline.get());
-        cb.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, render_pipeline.get_layout(), 0, render_dsh.get_sets()[gs.game_data.current_frame], {});
+        cb.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, render_pipeline.get_layout(), 0, render_dsh.get_sets()[gs.game_data.current_frame], mrd_offset);
         cb.draw(firefly_count, 1, 0, 0);
     }
 
@@ -128,7 +131,8 @@ namespace ve
         cb.bindPipeline(vk::PipelineBindPoint::eCompute, tunnel_collision_compute_pipeline.get());
         cb.bindDescriptorSets(vk::PipelineBindPoint::eCompute, tunnel_collision_compute_pipeline.get_layout(), 0, compute_dsh.get_sets()[current_frame], {});
         cb.pushConstants(tunnel_collision_compute_pipeline.get_layout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(FireflyMovePushConstants), &fmpc);
-        cb.dispatch((firefly_count + 31) / 32, ((indices_per_segment / 3) + 31) / 32, 1);
+        // one workgroup per firefly that only tests the triangles around it
+        cb.dispatch(firefly_count, 1, 1);
         timer.stop(cb, DeviceTimer::FIREFLY_MOVE_STEP, vk::PipelineStageFlagBits::eComputeShader);
     }
 } // namespace ve
@@ -69,6 +69,12 @@ namespace ve
         {
             vaci.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
         }
+        else if (usage & vk::ImageUsageFlagBits::eTransientAttachment)
+        {
+            // transient attachments are never loaded from or stored to memory, so tiled gpus do not need to back them with physical memory
+            vaci.usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+            vaci.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        }
         else
         {
             vaci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
@@ -79,6 +85,25 @@ namespace ve
         return image;
     }
 
+    void Image::create_aliasing_image(const std::vector<uint32_t>& queue_family_indices, vk::ImageUsageFlags usage)
+    {
+        vk::ImageCreateInfo ici{};
+        ici.sType = vk::StructureType::eImageCreateInfo;
+        ici.imageType = vk::ImageType::e2D;
+        ici.extent = vk::Extent3D(w, h, 1);
+        ici.mipLevels = mip_levels;
+        ici.arrayLayers = layer_count;
+        ici.format = format;
+        ici.tiling = vk::ImageTiling::eOptimal;
+        ici.initialLayout = vk::ImageLayout::eUndefined;
+        ici.usage = usage;
+        ici.sharingMode = queue_family_indices.size() == 1 ? vk::SharingMode::eExclusive : vk::SharingMode::eConcurrent;
+        ici.queueFamilyIndexCount = queue_family_indices.size();
+        ici.pQueueFamilyIndices = queue_family_indices.data();
+        ici.samples = vk::SampleCountFlagBits::e1;
+        VE_CHECK(vk::Result(vmaCreateAliasingImage(vmc.va, vmaa, (VkImageCreateInfo*) (&ici), (VkImage*) (&image))), "Failed to create aliasing image!");
+    }
+
     void perform_image_layout_transition(vk::CommandBuffer& cb, vk::Image image, vk::ImageLayout old_layout, vk::ImageLayout new_layout, vk::PipelineStageFlags src_stage_flags, vk::PipelineStageFlags dst_stage_flags, vk::AccessFlags src_access_flags, vk::AccessFlags dst_access_flags, uint32_t base_mip_level, uint32_t mip_levels, uint32_t layer_count)
     {
         // perform actual image layout transition independent from this image
@@ -102,33 +127,8 @@ namespace ve
         cb.pipelineBarrier(src_stage_flags, dst_stage_flags, {}, nullptr, nullptr, imb);
     }
 
-    void copy_buffer_to_image(VulkanCommandContext& vcc, const Buffer& buffer, vk::Extent3D extent, vk::Image image, uint32_t layer_count, uint32_t pixel_byte_size)
-    {
-        vk::CommandBuffer& cb = vcc.begin(vcc.transfer_cb[0]);
-        std::vector<vk::BufferImageCopy> copy_regions;
-        for (uint32_t i = 0; i < layer_count; ++i)
-        {
-            vk::BufferImageCopy copy_region{};
-            copy_region.bufferOffset = i * extent.width * extent.height * pixel_byte_size;
-            copy_region.bufferRowLength = 0;
-            copy_region.bufferImageHeight = 0;
-            copy_region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-            copy_region.imageSubresource.mipLevel = 0;
-            copy_region.imageSubresource.baseArrayLayer = i;
-            copy_region.imageSubresource.layerCount = 1;
-            copy_region.imageOffset = vk::Offset3D{0, 0, 0};
-            copy_region.imageExtent = extent;
-            copy_regions.push_back(copy_region);
-        }
-
-        cb.copyBufferToImage(buffer.get(), image, vk::ImageLayout::eTransferDstOptimal, copy_regions);
-        vcc.submit_transfer(cb, true);
-    }
-
     void Image::create_image_from_data(const unsigned char* data, VulkanCommandContext& vcc, const std::vector<uint32_t>& queue_family_indices, uint32_t base_mip_map_lvl, vk::ImageUsageFlags usage_flags)
     {
-        Buffer buffer(vmc, vcc, data, byte_size, vk::BufferUsageFlagBits::eTransferSrc, false, vmc.queue_family_indices.transfer);
-
         vk::FormatProperties format_properties = vmc.physical_device.get().getFormatProperties(format);
         if (!(format_properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear))
         {
@@ -136,12 +136,10 @@ namespace ve
             base_mip_map_lvl = 0;
         }
 
-        auto move_buffer_to_image = [&](vk::Image image, uint32_t mip_levels) -> void {
-            // copy image data to tmp_image
-            vk::CommandBuffer& cb = vcc.begin(vcc.graphics_cb[0]);
-            perform_image_layout_transition(cb, image, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, vk::AccessFlagBits::eTransferWrite, 0, mip_levels, layer_count);
-            vcc.submit_graphics(cb, true);
-            copy_buffer_to_image(vcc, buffer, vk::Extent3D(w, h, 1), image, layer_count, c);
+        auto upload_to_image = [&](vk::Image image, uint32_t mip_levels) -> void {
+            // transition and copy are recorded into the current upload batch, the following graphics submission waits for it
+            // data is always given with 4 channels
+            vcc.upload_context.upload_image(image, data, vk::Extent3D(w, h, 1), layer_count, 4, mip_levels);
         };
 
         // check if image should start at base_mip_map_lvl to save some storage
@@ -149,7 +147,7 @@ namespace ve
         if (base_mip_map_lvl > 0)
         {
             auto [tmp_image, tmp_alloc] = create_image({vmc.queue_family_indices.graphics, vmc.queue_family_indices.transfer}, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc, vk::SampleCountFlagBits::e1, false, format, vk::Extent3D(w, h, 1), layer_count, vmc.va);
-            move_buffer_to_image(tmp_image, 1);
+            upload_to_image(tmp_image, 1);
 
             vk::Offset3D tmp_image_offset(w, h, 1);
             mip_levels -= base_mip_map_lvl;
@@ -169,11 +167,10 @@ namespace ve
         }
         else
         {
-            // layout of image is transitioned in move_buffer_to_image
+            // layout of image is transitioned in upload_to_image
             std::tie(image, vmaa) = create_image(queue_family_indices, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc | usage_flags, vk::SampleCountFlagBits::e1, true, format, vk::Extent3D(w, h, 1), layer_count, vmc.va);
-            move_buffer_to_image(image, mip_levels);
+            upload_to_image(image, mip_levels);
         }
-        buffer.self_destruct();
         // set current layout of this image
         layout = vk::ImageLayout::eTransferDstOptimal;
         mip_levels > 1 ? generate_mipmaps(vcc) : transition_image_layout(vcc, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead);
@@ -230,7 +227,14 @@ namespace ve
     {
         vmc.logical_device.get().destroySampler(sampler);
         vmc.logical_device.get().destroyImageView(view);
-        vmaDestroyImage(vmc.va, VkImage(image), vmaa);
+        if (owns_memory)
+        {
+            vmaDestroyImage(vmc.va, VkImage(image), vmaa);
+        }
+        else
+        {
+            vmc.logical_device.get().destroyImage(image);
+        }
     }
 
     void Image::transition_image_layout(VulkanCommandContext& vcc, vk::ImageLayout new_layout, vk::PipelineStageFlags src_stage_flags, vk::PipelineStageFlags dst_stage_flags, vk::AccessFlags src_access_flags, vk::AccessFlags dst_access_flags)
@@ -334,6 +338,11 @@ namespace ve
         return sampler;
     }
 
+    VmaAllocation Image::get_allocation() const
+    {
+        return vmaa;
+    }
+
     void Image::generate_mipmaps(VulkanCommandContext& vcc)
     {
         vk::CommandBuffer& cb = vcc.begin(vcc.graphics_cb[0]);
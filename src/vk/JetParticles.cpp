@@ -6,7 +6,7 @@ namespace ve
 {
     constexpr uint32_t jet_particle_count = 20000;
 
-    JetParticles::JetParticles(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage) : render_dsh(vmc), compute_dsh(vmc), vmc(vmc), vcc(vcc), storage(storage), render_pipeline(vmc), move_compute_pipeline(vmc)
+    JetParticles::JetParticles(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage, UploadArena& upload_arena) : render_dsh(vmc), compute_dsh(vmc), vmc(vmc), vcc(vcc), storage(storage), upload_arena(upload_arena), render_pipeline(vmc), move_compute_pipeline(vmc)
     {}
 
     void JetParticles::self_destruct(bool full)
@@ -19,8 +19,6 @@ namespace ve
             compute_dsh.self_destruct();
             for (auto i : vertex_buffers) storage.destroy_buffer(i);
             vertex_buffers.clear();
-            for (auto i : model_render_data_buffers) storage.destroy_buffer(i);
-            model_render_data_buffers.clear();
         }
     }
 
@@ -31,12 +29,12 @@ namespace ve
         vertex_buffers.push_back(storage.add_named_buffer(std::string("jet_particle_vertices_1"), vertices, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.graphics, vmc.queue_family_indices.compute));
     }
 
-    void JetParticles::construct(const RenderPass& render_pass, const Mesh& spawn_mesh, const std::vector<uint32_t>& spawn_mesh_model_render_data_buffer, uint32_t spawn_mesh_model_render_data_idx)
+    void JetParticles::construct(const RenderPass& render_pass, const Mesh& spawn_mesh, const std::vector<BufferHandle>& spawn_mesh_model_render_data_buffer, uint32_t spawn_mesh_model_render_data_idx, PipelineBuilder& pipeline_builder)
     {
         spawn_mesh_model_render_data_buffer_count = storage.get_buffer(spawn_mesh_model_render_data_buffer[0]).get_element_count();
         spawn_mesh_model_render_data_buffer_idx = spawn_mesh_model_render_data_idx;
         mesh = spawn_mesh;
-        render_dsh.add_binding(0, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eVertex);
+        render_dsh.add_binding(0, vk::DescriptorType::eUniformBufferDynamic, vk::ShaderStageFlagBits::eVertex);
         compute_dsh.add_binding(0, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(2, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
@@ -44,13 +42,11 @@ namespace ve
         compute_dsh.add_binding(4, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(90, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eCompute);
 
-        // add one uniform buffer and descriptor set for each frame as the uniform buffer is changed in every frame
+        // one descriptor set for each frame, the model render data is placed in the upload arena of the frame every frame
         for (uint32_t i = 0; i < frames_in_flight; ++i)
         {
-            model_render_data_buffers.push_back(storage.add_buffer(std::vector<ModelRenderData>{mrd}, vk::BufferUsageFlagBits::eUniformBuffer, false, vmc.queue_family_indices.transfer, vmc.queue_family_indices.graphics));
-
             render_dsh.new_set();
-            render_dsh.add_descriptor(0, storage.get_buffer(model_render_data_buffers.back()));
+            render_dsh.add_descriptor(0, upload_arena.get_buffer(i), sizeof(ModelRenderData));
 
             compute_dsh.new_set();
             compute_dsh.add_descriptor(0, storage.get_buffer(vertex_buffers[1 - i]));
@@ -63,10 +59,10 @@ namespace ve
         render_dsh.construct();
         compute_dsh.construct();
 
-        construct_pipelines(render_pass);
+        construct_pipelines(render_pass, pipeline_builder);
     }
 
-    void JetParticles::construct_pipelines(const RenderPass& render_pass)
+    void JetParticles::construct_pipelines(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
         std::array<vk::SpecializationMapEntry, 2> vertex_entries;
         vertex_entries[0] = vk::SpecializationMapEntry(0, 0, sizeof(float));
@@ -77,7 +73,8 @@ namespace ve
         std::vector<ShaderInfo> shader_infos(2);
         shader_infos[0] = ShaderInfo{"jet_particles.vert", vk::ShaderStageFlagBits::eVertex, vertex_spec_info};
         shader_infos[1] = ShaderInfo{"jet_particles.frag", vk::ShaderStageFlagBits::eFragment};
-        render_pipeline.construct(render_pass, render_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::ePoint, JetParticleVertex::get_binding_descriptions(), JetParticleVertex::get_attribute_descriptions(), vk::PrimitiveTopology::ePointList, {});
+        render_pipeline.describe(render_pass, render_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::ePoint, JetParticleVertex::get_binding_descriptions(), JetParticleVertex::get_attribute_descriptions(), vk::PrimitiveTopology::ePointList, {});
+        pipeline_builder.add(render_pipeline);
 
         std::array<vk::SpecializationMapEntry, 6> compute_entries;
         compute_entries[0] = vk::SpecializationMapEntry(0, 0, sizeof(uint32_t));
@@ -90,13 +87,15 @@ namespace ve
         std::array<uint32_t, 6> compute_entries_data{jet_particle_count, mesh.index_offset, mesh.index_count, spawn_mesh_model_render_data_buffer_count, spawn_mesh_model_render_data_buffer_idx, *reinterpret_cast<uint32_t*>(&lifetime)};
         vk::SpecializationInfo compute_spec_info(compute_entries.size(), compute_entries.data(), compute_entries_data.size() * sizeof(uint32_t), compute_entries_data.data());
 
-        move_compute_pipeline.construct(compute_dsh.get_layouts()[0], ShaderInfo{"jet_particles_move.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, 0);
+        move_compute_pipeline.describe(compute_dsh.get_layouts()[0], ShaderInfo{"jet_particles_move.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, 0);
+
+        pipeline_builder.add(move_compute_pipeline);
     }
 
-    void JetParticles::reload_shaders(const RenderPass& render_pass)
+    void JetParticles::reload_shaders(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
         self_destruct(false);
-        construct_pipelines(render_pass);
+        construct_pipelines(render_pass, pipeline_builder);
     }
 
     void JetParticles::draw(vk::CommandBuffer& cb, GameState& gs)
@@ -104,9 +103,9 @@ namespace ve
         cb.bindVertexBuffers(0, storage.get_buffer(vertex_buffers[gs.game_data.current_frame]).get(), {0});
         mrd.prev_MVP = mrd.MVP;
         mrd.MVP = gs.cam.getVP();
-        storage.get_buffer(model_render_data_buffers[gs.game_data.current_frame]).update_data(std::vector<ModelRenderData>{mrd});
+        const uint32_t mrd_offset = upload_arena.upload(gs.game_data.current_frame, mrd);
         cb.bindPipeline(vk::PipelineBindPoint::eGraphics, render_pipeline.get());
-        cb.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, render_pipeline.get_layout(), 0, render_dsh.get_sets()[gs.game_data.current_frame], {});
+        cb.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, render_pipeline.get_layout(), 0, render_dsh.get_sets()[gs.game_data.current_frame], mrd_offset);
         cb.draw(jet_particle_count, 1, 0, 0);
     }
 
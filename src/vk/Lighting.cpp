@@ -10,9 +10,9 @@ Lighting::Lighting(const VulkanMainContext& vmc, Storage& storage) : vmc(vmc), s
 {
 }
 
-void Lighting::construct(uint32_t light_count, const Swapchain& swapchain)
+void Lighting::construct(uint32_t light_count, const Swapchain& swapchain, PipelineBuilder& pipeline_builder)
 {
-    create_lighting_pipeline(light_count, swapchain);
+    create_lighting_pipeline(light_count, swapchain, pipeline_builder);
 }
 
 void Lighting::self_destruct()
@@ -20,7 +20,7 @@ void Lighting::self_destruct()
     lighting_pipeline_0.self_destruct();
     lighting_pipeline_1.self_destruct();
     lighting_dsh.self_destruct();
-    for (uint32_t i : restir_reservoir_buffers) storage.destroy_buffer(i);
+    for (BufferHandle b : restir_reservoir_buffers) storage.destroy_buffer(b);
     restir_reservoir_buffers.clear();
 }
 
@@ -44,7 +44,7 @@ void Lighting::main_pass(vk::CommandBuffer& cb, GameState& gs)
     }
 }
 
-void Lighting::create_lighting_pipeline(uint32_t light_count, const Swapchain& swapchain)
+void Lighting::create_lighting_pipeline(uint32_t light_count, const Swapchain& swapchain, PipelineBuilder& pipeline_builder)
 {
     create_lighting_descriptor_sets(swapchain.get_extent());
     std::vector<ShaderInfo> shader_infos(2);
@@ -61,11 +61,13 @@ void Lighting::create_lighting_pipeline(uint32_t light_count, const Swapchain& s
 
     shader_infos[0] = ShaderInfo{"lighting.vert", vk::ShaderStageFlagBits::eVertex};
     shader_infos[1] = ShaderInfo{"lighting.frag", vk::ShaderStageFlagBits::eFragment, fragment_spec_info};
-    lighting_pipeline_0.construct(swapchain.get_render_pass(), lighting_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eFill, std::vector<vk::VertexInputBindingDescription>(), std::vector<vk::VertexInputAttributeDescription>(), vk::PrimitiveTopology::eTriangleList, {});
+    lighting_pipeline_0.describe(swapchain.get_render_pass(), lighting_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eFill, std::vector<vk::VertexInputBindingDescription>(), std::vector<vk::VertexInputAttributeDescription>(), vk::PrimitiveTopology::eTriangleList, {});
+    pipeline_builder.add(lighting_pipeline_0);
 
     fragment_entries_data[6] = 0;
     shader_infos[1] = ShaderInfo{"lighting.frag", vk::ShaderStageFlagBits::eFragment, fragment_spec_info};
-    lighting_pipeline_1.construct(swapchain.get_render_pass(), lighting_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eFill, std::vector<vk::VertexInputBindingDescription>(), std::vector<vk::VertexInputAttributeDescription>(), vk::PrimitiveTopology::eTriangleList, {});
+    lighting_pipeline_1.describe(swapchain.get_render_pass(), lighting_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eFill, std::vector<vk::VertexInputBindingDescription>(), std::vector<vk::VertexInputAttributeDescription>(), vk::PrimitiveTopology::eTriangleList, {});
+    pipeline_builder.add(lighting_pipeline_1);
 }
 
 void Lighting::create_lighting_descriptor_sets(vk::Extent2D swapchain_extent)
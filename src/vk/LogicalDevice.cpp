@@ -35,6 +35,7 @@ namespace ve
         vk::PhysicalDeviceVulkan12Features device_features_12;
         device_features_12.pNext = &as_features;
         device_features_12.bufferDeviceAddress = VK_TRUE;
+        device_features_12.timelineSemaphore = VK_TRUE;
 
         vk::PhysicalDeviceVulkan13Features device_features_13;
         device_features_13.pNext = &device_features_12;
@@ -1,8 +1,14 @@
 #include "vk/PathTracer.hpp"
+#include <algorithm>
+#include "ve_log.hpp"
 
 namespace ve 
 {
-    PathTracer::PathTracer(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage) : vmc(vmc), vcc(vcc), storage(storage) {}
+    PathTracer::PathTracer(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage) : vmc(vmc), vcc(vcc), storage(storage)
+    {
+        auto properties = vmc.physical_device.get().getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceAccelerationStructurePropertiesKHR>();
+        scratch_alignment = properties.get<vk::PhysicalDeviceAccelerationStructurePropertiesKHR>().minAccelerationStructureScratchOffsetAlignment;
+    }
 
     void PathTracer::self_destruct()
     {
@@ -10,20 +16,23 @@ namespace ve
         {
             vmc.logical_device.get().destroyAccelerationStructureKHR(topLevelAS[i].handle);
             storage.destroy_buffer(topLevelAS[i].buffer);
-            storage.destroy_buffer(topLevelAS[i].scratch_buffer);
             storage.destroy_buffer(instances_buffer[i]);
+            if (scratch_arenas[i].size > 0) storage.destroy_buffer(scratch_arenas[i].buffer);
+            scratch_arenas[i] = ScratchArena{};
 
             for (auto& blas : bottomLevelAS[i])
             {
+                // static blas are shared and only destroyed with the blas of frame 0
+                if (blas.is_static && i > 0) continue;
                 vmc.logical_device.get().destroyAccelerationStructureKHR(blas.handle);
                 storage.destroy_buffer(blas.buffer);
-                storage.destroy_buffer(blas.scratch_buffer);
             }
             bottomLevelAS[i].clear();
         }
+        release_retired_scratch_buffers();
     }
 
-    void PathTracer::create_blas(vk::CommandBuffer& cb, uint32_t vertex_buffer_id, uint32_t index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, vk::DeviceSize vertex_stride, BottomLevelAccelerationStructure& blas)
+    void PathTracer::create_blas(vk::CommandBuffer& cb, BufferHandle vertex_buffer_id, BufferHandle index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, vk::DeviceSize vertex_stride, BottomLevelAccelerationStructure& blas, ScratchArena& arena)
     {
         Buffer& vertex_buffer = storage.get_buffer(vertex_buffer_id);
         Buffer& index_buffer = storage.get_buffer(index_buffer_id);
@@ -64,6 +73,8 @@ namespace ve
         vk::AccelerationStructureBuildGeometryInfoKHR asbgi{};
         asbgi.type = vk::AccelerationStructureTypeKHR::eBottomLevel;
         asbgi.flags = vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace;
+        // static blas are compacted after their initial build
+        if (blas.is_static) asbgi.flags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowCompaction;
         asbgi.mode = vk::BuildAccelerationStructureModeKHR::eBuild;
         asbgi.geometryCount = asgs.size();
         asbgi.pGeometries = asgs.data();
@@ -87,32 +98,162 @@ namespace ve
 
             blas.deviceAddress = vmc.logical_device.get().getAccelerationStructureAddressKHR(&asdai);
 
-            blas.scratch_buffer = storage.add_buffer(asbsi.buildScratchSize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress, true, vmc.queue_family_indices.graphics, vmc.queue_family_indices.compute); 
+            blas.scratch_size = asbsi.buildScratchSize;
         }
 
         asbgi.dstAccelerationStructure = blas.handle;
-        asbgi.scratchData.deviceAddress = storage.get_buffer(blas.scratch_buffer).get_device_address();
+        asbgi.scratchData.deviceAddress = allocate_scratch(arena, blas.scratch_size);
         std::vector<vk::AccelerationStructureBuildGeometryInfoKHR> asbgis{};
         asbgis.push_back(asbgi);
 
         cb.buildAccelerationStructuresKHR(asbgis, pasbris);
-        vk::BufferMemoryBarrier buffer_memory_barrier(vk::AccessFlagBits::eAccelerationStructureWriteKHR, vk::AccessFlagBits::eAccelerationStructureReadKHR, vmc.queue_family_indices.compute, vmc.queue_family_indices.compute, storage.get_buffer(blas.buffer).get(), 0, storage.get_buffer(blas.buffer).get_byte_size());
-        cb.pipelineBarrier(vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, vk::DependencyFlagBits::eDeviceGroup, {}, {buffer_memory_barrier}, {});
+        // global barrier to also cover the scratch memory that the next build reuses
+        vk::MemoryBarrier memory_barrier(vk::AccessFlagBits::eAccelerationStructureWriteKHR, vk::AccessFlagBits::eAccelerationStructureReadKHR | vk::AccessFlagBits::eAccelerationStructureWriteKHR);
+        cb.pipelineBarrier(vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, vk::DependencyFlagBits::eDeviceGroup, {memory_barrier}, {}, {});
+        reset_scratch(arena);
         blas.is_built = true;
     }
 
-    uint32_t PathTracer::add_blas(vk::CommandBuffer& cb, uint32_t vertex_buffer_id, uint32_t index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, vk::DeviceSize vertex_stride) 
+    uint32_t PathTracer::add_blas(vk::CommandBuffer& cb, BufferHandle vertex_buffer_id, BufferHandle index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, vk::DeviceSize vertex_stride, bool is_static) 
     {
         bottomLevelAS[0].push_back(BottomLevelAccelerationStructure{});
-        create_blas(cb, vertex_buffer_id, index_buffer_id, index_offsets, index_counts, vertex_stride, bottomLevelAS[0].back());
-        bottomLevelAS[1].push_back(BottomLevelAccelerationStructure{});
-        create_blas(cb, vertex_buffer_id, index_buffer_id, index_offsets, index_counts, vertex_stride, bottomLevelAS[1].back());
+        bottomLevelAS[0].back().is_static = is_static;
+        create_blas(cb, vertex_buffer_id, index_buffer_id, index_offsets, index_counts, vertex_stride, bottomLevelAS[0].back(), load_scratch_arena);
+        if (is_static)
+        {
+            bottomLevelAS[1].push_back(bottomLevelAS[0].back());
+        }
+        else
+        {
+            bottomLevelAS[1].push_back(BottomLevelAccelerationStructure{});
+            create_blas(cb, vertex_buffer_id, index_buffer_id, index_offsets, index_counts, vertex_stride, bottomLevelAS[1].back(), load_scratch_arena);
+        }
         return bottomLevelAS[0].size() - 1;
     }
 
-    void PathTracer::update_blas(uint32_t vertex_buffer_id, uint32_t index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, uint32_t blas_idx, vk::DeviceSize vertex_stride)
+    void PathTracer::compact_static_blas()
     {
+        std::vector<uint32_t> blas_indices;
+        std::vector<vk::AccelerationStructureKHR> handles;
+        for (uint32_t i = 0; i < bottomLevelAS[0].size(); ++i)
+        {
+            if (!bottomLevelAS[0][i].is_static || bottomLevelAS[0][i].is_compacted) continue;
+            blas_indices.push_back(i);
+            handles.push_back(bottomLevelAS[0][i].handle);
+        }
+        if (blas_indices.empty()) return;
+
+        vk::QueryPoolCreateInfo qpci{};
+        qpci.sType = vk::StructureType::eQueryPoolCreateInfo;
+        qpci.queryType = vk::QueryType::eAccelerationStructureCompactedSizeKHR;
+        qpci.queryCount = handles.size();
+        vk::QueryPool qp = vmc.logical_device.get().createQueryPool(qpci);
+
+        vk::CommandBuffer& query_cb = vcc.begin(vcc.compute_cb[0]);
+        query_cb.resetQueryPool(qp, 0, handles.size());
+        query_cb.writeAccelerationStructuresPropertiesKHR(handles, vk::QueryType::eAccelerationStructureCompactedSizeKHR, qp, 0);
+        vcc.submit_compute(query_cb, true);
+
+        std::vector<vk::DeviceSize> compacted_sizes(handles.size());
+        vk::Result result = vmc.logical_device.get().getQueryPoolResults(qp, 0, handles.size(), compacted_sizes.size() * sizeof(vk::DeviceSize), compacted_sizes.data(), sizeof(vk::DeviceSize), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+        vmc.logical_device.get().destroyQueryPool(qp);
+        VE_CHECK(result, "Failed to query compacted blas sizes!");
+
+        vk::DeviceSize original_size = 0;
+        vk::DeviceSize compacted_size = 0;
+        std::vector<BottomLevelAccelerationStructure> old_blas;
+        vk::CommandBuffer& copy_cb = vcc.begin(vcc.compute_cb[0]);
+        for (uint32_t i = 0; i < blas_indices.size(); ++i)
+        {
+            BottomLevelAccelerationStructure& blas = bottomLevelAS[0][blas_indices[i]];
+            old_blas.push_back(blas);
+            original_size += storage.get_buffer(blas.buffer).get_byte_size();
+            compacted_size += compacted_sizes[i];
+
+            blas.buffer = storage.add_buffer(compacted_sizes[i], vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR, true, vmc.queue_family_indices.graphics, vmc.queue_family_indices.compute);
+
+            vk::AccelerationStructureCreateInfoKHR asci{};
+            asci.sType = vk::StructureType::eAccelerationStructureCreateInfoKHR;
+            asci.buffer = storage.get_buffer(blas.buffer).get();
+            asci.size = compacted_sizes[i];
+            asci.type = vk::AccelerationStructureTypeKHR::eBottomLevel;
+            blas.handle = vmc.logical_device.get().createAccelerationStructureKHR(asci);
+
+            vk::CopyAccelerationStructureInfoKHR casi{};
+            casi.sType = vk::StructureType::eCopyAccelerationStructureInfoKHR;
+            casi.src = old_blas.back().handle;
+            casi.dst = blas.handle;
+            casi.mode = vk::CopyAccelerationStructureModeKHR::eCompact;
+            copy_cb.copyAccelerationStructureKHR(casi);
+
+            vk::AccelerationStructureDeviceAddressInfoKHR asdai{};
+            asdai.sType = vk::StructureType::eAccelerationStructureDeviceAddressInfoKHR;
+            asdai.accelerationStructure = blas.handle;
+            blas.deviceAddress = vmc.logical_device.get().getAccelerationStructureAddressKHR(&asdai);
+            blas.is_compacted = true;
+            // static blas are shared between both frames
+            bottomLevelAS[1][blas_indices[i]] = blas;
+        }
+        vcc.submit_compute(copy_cb, true);
+
+        // instances that were already added still reference the original blas
+        for (uint32_t i = 0; i < blas_indices.size(); ++i)
+        {
+            for (auto& frame_instances : instances)
+            {
+                for (auto& instance : frame_instances)
+                {
+                    if (instance.accelerationStructureReference == old_blas[i].deviceAddress) instance.accelerationStructureReference = bottomLevelAS[0][blas_indices[i]].deviceAddress;
+                }
+            }
+            vmc.logical_device.get().destroyAccelerationStructureKHR(old_blas[i].handle);
+            storage.destroy_buffer(old_blas[i].buffer);
+        }
+        tlas_needs_rebuild = {true, true};
+        spdlog::info("Compacted {} static blas from {} KiB to {} KiB, saved {} KiB", blas_indices.size(), original_size / 1024, compacted_size / 1024, (original_size - compacted_size) / 1024);
+    }
+
+    void PathTracer::release_retired_scratch_buffers()
+    {
+        for (auto& arena : scratch_arenas)
+        {
+            for (BufferHandle buffer : arena.retired_buffers) storage.destroy_buffer(buffer);
+            arena.retired_buffers.clear();
+        }
+        for (BufferHandle buffer : load_scratch_arena.retired_buffers) storage.destroy_buffer(buffer);
+        if (load_scratch_arena.size > 0) storage.destroy_buffer(load_scratch_arena.buffer);
+        load_scratch_arena = ScratchArena{};
+    }
+
+    vk::DeviceAddress PathTracer::allocate_scratch(ScratchArena& arena, vk::DeviceSize size)
+    {
+        size = (size + scratch_alignment - 1) / scratch_alignment * scratch_alignment;
+        if (arena.offset + size > arena.size)
+        {
+            // the old buffer may still be in use by builds recorded since the last reset
+            if (arena.size > 0) arena.retired_buffers.push_back(arena.buffer);
+            arena.size = arena.offset + size;
+            // over-allocate by the alignment to be able to align the base address
+            arena.buffer = storage.add_buffer(arena.size + scratch_alignment, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress, true, vmc.queue_family_indices.graphics, vmc.queue_family_indices.compute);
+            arena.base_address = (storage.get_buffer(arena.buffer).get_device_address() + scratch_alignment - 1) / scratch_alignment * scratch_alignment;
+            arena.offset = 0;
+        }
+        vk::DeviceAddress address = arena.base_address + arena.offset;
+        arena.offset += size;
+        return address;
+    }
+
+    void PathTracer::reset_scratch(ScratchArena& arena)
+    {
+        arena.offset = 0;
+    }
+
+    void PathTracer::update_blas(BufferHandle vertex_buffer_id, BufferHandle index_buffer_id, const std::vector<uint32_t>& index_offsets, const std::vector<uint32_t>& index_counts, uint32_t blas_idx, vk::DeviceSize vertex_stride)
+    {
+        VE_ASSERT(!bottomLevelAS[0][blas_idx].is_static, "Cannot update static blas {}!", blas_idx);
         for (auto& i : bottomLevelAS_dirty_build_info) i.push_back(BLASBuildInfo{vertex_buffer_id, index_buffer_id, index_offsets, index_counts, vertex_stride, blas_idx});
+        // a refit would keep the tlas hierarchy of the old blas bounds
+        tlas_needs_rebuild = {true, true};
     }
 
     uint32_t PathTracer::add_instance(uint32_t blas_idx, const glm::mat4& M, uint32_t custom_index, uint32_t mask)
@@ -126,27 +267,41 @@ namespace ve
         instances[0].push_back(instance);
         instance.accelerationStructureReference = bottomLevelAS[1][blas_idx].deviceAddress;
         instances[1].push_back(instance);
+        tlas_needs_rebuild = {true, true};
         return instances[0].size() - 1;
     }
 
     void PathTracer::update_instance(uint32_t instance_idx, const glm::mat4& M)
     {
-        instances[0][instance_idx].transform = std::array<std::array<float, 4>, 3>({std::array<float, 4>({M[0][0], M[1][0], M[2][0], M[3][0]}), std::array<float, 4>({M[0][1], M[1][1], M[2][1], M[3][1]}), std::array<float, 4>({M[0][2], M[1][2], M[2][2], M[3][2]})});
-        instances[1][instance_idx].transform = std::array<std::array<float, 4>, 3>({std::array<float, 4>({M[0][0], M[1][0], M[2][0], M[3][0]}), std::array<float, 4>({M[0][1], M[1][1], M[2][1], M[3][1]}), std::array<float, 4>({M[0][2], M[1][2], M[2][2], M[3][2]})});
+        vk::TransformMatrixKHR transform(std::array<std::array<float, 4>, 3>({std::array<float, 4>({M[0][0], M[1][0], M[2][0], M[3][0]}), std::array<float, 4>({M[0][1], M[1][1], M[2][1], M[3][1]}), std::array<float, 4>({M[0][2], M[1][2], M[2][2], M[3][2]})}));
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            if (instances[i][instance_idx].transform == transform) continue;
+            instances[i][instance_idx].transform = transform;
+            instances_dirty[i] = true;
+        }
     }
 
     void PathTracer::create_tlas(vk::CommandBuffer& cb, uint32_t frame_idx)
     {
+        // the previous command buffer of this frame has finished, so retired scratch buffers of the frame are unused
+        for (BufferHandle buffer : scratch_arenas[frame_idx].retired_buffers) storage.destroy_buffer(buffer);
+        scratch_arenas[frame_idx].retired_buffers.clear();
         for (const BLASBuildInfo& b : bottomLevelAS_dirty_build_info[frame_idx])
         {
-            create_blas(cb, b.vertex_buffer_id, b.index_buffer_id, b.index_offsets, b.index_counts, b.vertex_stride, bottomLevelAS[frame_idx][b.blas_idx]);
+            create_blas(cb, b.vertex_buffer_id, b.index_buffer_id, b.index_offsets, b.index_counts, b.vertex_stride, bottomLevelAS[frame_idx][b.blas_idx], scratch_arenas[frame_idx]);
         }
         bottomLevelAS_dirty_build_info[frame_idx].clear();
+        if (topLevelAS[frame_idx].is_built && !tlas_needs_rebuild[frame_idx] && !instances_dirty[frame_idx]) return;
         if (!topLevelAS[frame_idx].is_built)
         {
             instances_buffer[frame_idx] = storage.add_buffer(instances[frame_idx].data(), instances[frame_idx].size(), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR, false, vmc.queue_family_indices.graphics, vmc.queue_family_indices.compute);
+            topLevelAS[frame_idx].instance_count = instances[frame_idx].size();
         }
+        VE_ASSERT(topLevelAS[frame_idx].instance_count == instances[frame_idx].size(), "Instances were added after the creation of the tlas ({} instead of {})!", instances[frame_idx].size(), topLevelAS[frame_idx].instance_count);
         storage.get_buffer(instances_buffer[frame_idx]).update_data(instances[frame_idx]);
+        // refit the existing tlas if only the transforms of instances changed
+        const bool refit = topLevelAS[frame_idx].is_built && !tlas_needs_rebuild[frame_idx];
 
         vk::DeviceOrHostAddressConstKHR instance_data_device_address;
         instance_data_device_address.deviceAddress = storage.get_buffer(instances_buffer[frame_idx]).get_device_address();
@@ -160,8 +315,8 @@ namespace ve
 
         vk::AccelerationStructureBuildGeometryInfoKHR asbgi;
         asbgi.type = vk::AccelerationStructureTypeKHR::eTopLevel;
-        asbgi.flags = vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace;
-        asbgi.mode = vk::BuildAccelerationStructureModeKHR::eBuild;
+        asbgi.flags = vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace | vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate;
+        asbgi.mode = refit ? vk::BuildAccelerationStructureModeKHR::eUpdate : vk::BuildAccelerationStructureModeKHR::eBuild;
         asbgi.geometryCount = 1;
         asbgi.pGeometries = &asg;
 
@@ -190,11 +345,13 @@ namespace ve
             wdsas[frame_idx].pAccelerationStructures = &(topLevelAS[frame_idx].handle);
             storage.get_buffer(topLevelAS[frame_idx].buffer).pNext = &(wdsas[frame_idx]);
 
-            topLevelAS[frame_idx].scratch_buffer = storage.add_buffer(asbsi.buildScratchSize, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress, true, vmc.queue_family_indices.graphics, vmc.queue_family_indices.compute); 
+            // the scratch memory is used for full builds and refits
+            topLevelAS[frame_idx].scratch_size = std::max(asbsi.buildScratchSize, asbsi.updateScratchSize);
         }
 
+        if (refit) asbgi.srcAccelerationStructure = topLevelAS[frame_idx].handle;
         asbgi.dstAccelerationStructure = topLevelAS[frame_idx].handle;
-        asbgi.scratchData.deviceAddress = storage.get_buffer(topLevelAS[frame_idx].scratch_buffer).get_device_address();
+        asbgi.scratchData.deviceAddress = allocate_scratch(scratch_arenas[frame_idx], topLevelAS[frame_idx].scratch_size);
 
         vk::AccelerationStructureBuildRangeInfoKHR asbri{};
         asbri.primitiveCount = instances[frame_idx].size();
@@ -204,6 +361,10 @@ namespace ve
         std::vector<vk::AccelerationStructureBuildRangeInfoKHR*> asbris = {&asbri};
 
         cb.buildAccelerationStructuresKHR(asbgi, asbris);
+        // the arena is next used by this frame after its command buffer has finished
+        reset_scratch(scratch_arenas[frame_idx]);
         topLevelAS[frame_idx].is_built = true;
+        instances_dirty[frame_idx] = false;
+        tlas_needs_rebuild[frame_idx] = false;
     }
 } // namespace ve
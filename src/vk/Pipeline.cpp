@@ -15,16 +15,91 @@ namespace ve
         vmc.logical_device.get().destroyPipelineLayout(pipeline_layout);
     }
 
+    void Pipeline::describe(const RenderPass& render_pass, std::optional<vk::DescriptorSetLayout> set_layout, const std::vector<ShaderInfo>& shader_infos, vk::PolygonMode polygon_mode, const std::vector<vk::VertexInputBindingDescription>& binding_descriptions, const std::vector<vk::VertexInputAttributeDescription>& attribute_description, const vk::PrimitiveTopology& primitive_topology, const std::vector<vk::PushConstantRange>& pcrs)
+    {
+        stage_descriptions.clear();
+        for (const auto& shader_info : shader_infos) add_stage_description(shader_info);
+        graphics_description = GraphicsDescription{render_pass.get(), render_pass.attachment_count, polygon_mode, binding_descriptions, attribute_description, primitive_topology};
+
+        vk::PipelineLayoutCreateInfo plci{};
+        plci.sType = vk::StructureType::ePipelineLayoutCreateInfo;
+        if (set_layout.has_value())
+        {
+            plci.setLayoutCount = 1;
+            plci.pSetLayouts = &set_layout.value();
+        }
+        plci.pushConstantRangeCount = pcrs.size();
+        plci.pPushConstantRanges = pcrs.data();
+
+        pipeline_layout = vmc.logical_device.get().createPipelineLayout(plci);
+    }
+
+    void Pipeline::describe(vk::DescriptorSetLayout set_layout, const ShaderInfo& shader_info, uint32_t push_constant_byte_size)
+    {
+        stage_descriptions.clear();
+        add_stage_description(shader_info);
+        graphics_description.reset();
+
+        vk::PushConstantRange pcr;
+        pcr.offset = 0;
+        pcr.size = push_constant_byte_size;
+        pcr.stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+        vk::PipelineLayoutCreateInfo plci{};
+        plci.sType = vk::StructureType::ePipelineLayoutCreateInfo;
+        plci.setLayoutCount = 1;
+        plci.pSetLayouts = &set_layout;
+        if (push_constant_byte_size > 0)
+        {
+            plci.pushConstantRangeCount = 1;
+            plci.pPushConstantRanges = &pcr;
+        }
+
+        pipeline_layout = vmc.logical_device.get().createPipelineLayout(plci);
+    }
+
+    void Pipeline::build()
+    {
+        graphics_description.has_value() ? build_graphics() : build_compute();
+        stage_descriptions.clear();
+        graphics_description.reset();
+    }
+
     void Pipeline::construct(const RenderPass& render_pass, std::optional<vk::DescriptorSetLayout> set_layout, const std::vector<ShaderInfo>& shader_infos, vk::PolygonMode polygon_mode, const std::vector<vk::VertexInputBindingDescription>& binding_descriptions, const std::vector<vk::VertexInputAttributeDescription>& attribute_description, const vk::PrimitiveTopology& primitive_topology, const std::vector<vk::PushConstantRange>& pcrs)
     {
+        describe(render_pass, set_layout, shader_infos, polygon_mode, binding_descriptions, attribute_description, primitive_topology, pcrs);
+        build();
+    }
+
+    void Pipeline::construct(vk::DescriptorSetLayout set_layout, const ShaderInfo& shader_info, uint32_t push_constant_byte_size)
+    {
+        describe(set_layout, shader_info, push_constant_byte_size);
+        build();
+    }
+
+    void Pipeline::add_stage_description(const ShaderInfo& shader_info)
+    {
+        StageDescription sd{shader_info.shader_name, shader_info.stage_flag, {}, {}};
+        const vk::SpecializationInfo& si = shader_info.spec_info;
+        if (si.mapEntryCount > 0) sd.spec_entries.assign(si.pMapEntries, si.pMapEntries + si.mapEntryCount);
+        if (si.dataSize > 0) sd.spec_data.assign(static_cast<const uint8_t*>(si.pData), static_cast<const uint8_t*>(si.pData) + si.dataSize);
+        stage_descriptions.push_back(sd);
+    }
+
+    void Pipeline::build_graphics()
+    {
+        const GraphicsDescription& gd = graphics_description.value();
         std::vector<Shader> shaders;
+        std::vector<vk::SpecializationInfo> spec_infos(stage_descriptions.size());
         std::vector<vk::PipelineShaderStageCreateInfo> shader_stages;
-        for (const auto& shader_info : shader_infos)
+        for (uint32_t i = 0; i < stage_descriptions.size(); ++i)
         {
-            Shader shader(vmc.logical_device.get(), shader_info.shader_name, shader_info.stage_flag);
+            const StageDescription& sd = stage_descriptions[i];
+            Shader shader(vmc.logical_device.get(), sd.shader_name, sd.stage_flag);
             shaders.push_back(shader);
+            spec_infos[i] = vk::SpecializationInfo(sd.spec_entries.size(), sd.spec_entries.data(), sd.spec_data.size(), sd.spec_data.data());
             vk::PipelineShaderStageCreateInfo pssci = shader.get_stage_create_info();
-            pssci.pSpecializationInfo = &shader_info.spec_info;
+            pssci.pSpecializationInfo = &spec_infos[i];
             shader_stages.push_back(pssci);
         }
 
@@ -36,14 +111,14 @@ namespace ve
 
         vk::PipelineVertexInputStateCreateInfo pvisci{};
         pvisci.sType = vk::StructureType::ePipelineVertexInputStateCreateInfo;
-        pvisci.vertexBindingDescriptionCount = binding_descriptions.size();
-        pvisci.pVertexBindingDescriptions = binding_descriptions.data();
-        pvisci.vertexAttributeDescriptionCount = attribute_description.size();
-        pvisci.pVertexAttributeDescriptions = attribute_description.data();
+        pvisci.vertexBindingDescriptionCount = gd.binding_descriptions.size();
+        pvisci.pVertexBindingDescriptions = gd.binding_descriptions.data();
+        pvisci.vertexAttributeDescriptionCount = gd.attribute_descriptions.size();
+        pvisci.pVertexAttributeDescriptions = gd.attribute_descriptions.data();
 
         vk::PipelineInputAssemblyStateCreateInfo piasci{};
         piasci.sType = vk::StructureType::ePipelineInputAssemblyStateCreateInfo;
-        piasci.topology = primitive_topology;
+        piasci.topology = gd.primitive_topology;
         piasci.primitiveRestartEnable = VK_FALSE;
 
         /*
@@ -70,7 +145,7 @@ namespace ve
         prsci.sType = vk::StructureType::ePipelineRasterizationStateCreateInfo;
         prsci.depthClampEnable = VK_FALSE;
         prsci.rasterizerDiscardEnable = VK_FALSE;
-        prsci.polygonMode = polygon_mode;
+        prsci.polygonMode = gd.polygon_mode;
         prsci.lineWidth = 0.5f;
         prsci.cullMode = vk::CullModeFlagBits::eNone;
         prsci.frontFace = vk::FrontFace::eCounterClockwise;
@@ -88,8 +163,8 @@ namespace ve
         pmssci.alphaToCoverageEnable = VK_FALSE;
         pmssci.alphaToOneEnable = VK_FALSE;
 
-        std::vector<vk::PipelineColorBlendAttachmentState> pcbas(render_pass.attachment_count);
-        for (uint32_t i = 0; i < render_pass.attachment_count; ++i)
+        std::vector<vk::PipelineColorBlendAttachmentState> pcbas(gd.attachment_count);
+        for (uint32_t i = 0; i < gd.attachment_count; ++i)
         {
             pcbas[i].colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
             pcbas[i].blendEnable = VK_FALSE;
@@ -112,18 +187,6 @@ namespace ve
         pcbsci.blendConstants[2] = 0.0f;
         pcbsci.blendConstants[3] = 0.0f;
 
-        vk::PipelineLayoutCreateInfo plci{};
-        plci.sType = vk::StructureType::ePipelineLayoutCreateInfo;
-        if (set_layout.has_value())
-        {
-            plci.setLayoutCount = 1;
-            plci.pSetLayouts = &set_layout.value();
-        }
-        plci.pushConstantRangeCount = pcrs.size();
-        plci.pPushConstantRanges = pcrs.data();
-
-        pipeline_layout = vmc.logical_device.get().createPipelineLayout(plci);
-
         vk::PipelineDepthStencilStateCreateInfo pdssci{};
         pdssci.sType = vk::StructureType::ePipelineDepthStencilStateCreateInfo;
         pdssci.depthTestEnable = VK_TRUE;
@@ -149,49 +212,34 @@ namespace ve
         gpci.pColorBlendState = &pcbsci;
         gpci.pDynamicState = &pdsci;
         gpci.layout = pipeline_layout;
-        gpci.renderPass = render_pass.get();
+        gpci.renderPass = gd.render_pass;
         gpci.subpass = 0;
         // it is possible to create a new pipeline by deriving from an existing one
         gpci.basePipelineHandle = VK_NULL_HANDLE;
         gpci.basePipelineIndex = -1;
 
-        vk::ResultValue<vk::Pipeline> pipeline_result_value = vmc.logical_device.get().createGraphicsPipeline(VK_NULL_HANDLE, gpci);
+        vk::ResultValue<vk::Pipeline> pipeline_result_value = vmc.logical_device.get().createGraphicsPipeline(vmc.pipeline_cache.get(), gpci);
         VE_CHECK(pipeline_result_value.result, "Failed to create pipeline!");
         pipeline = pipeline_result_value.value;
 
         for (auto& shader : shaders) shader.self_destruct();
     }
 
-    void Pipeline::construct(vk::DescriptorSetLayout set_layout, const ShaderInfo& shader_info, uint32_t push_constant_byte_size)
+    void Pipeline::build_compute()
     {
-        Shader shader(vmc.logical_device.get(), shader_info.shader_name, vk::ShaderStageFlagBits::eCompute);
-
-        vk::PushConstantRange pcr;
-        pcr.offset = 0;
-        pcr.size = push_constant_byte_size;
-        pcr.stageFlags = vk::ShaderStageFlagBits::eCompute;
-
-        vk::PipelineLayoutCreateInfo plci{};
-        plci.sType = vk::StructureType::ePipelineLayoutCreateInfo;
-        plci.setLayoutCount = 1;
-        plci.pSetLayouts = &set_layout;
-        if (push_constant_byte_size > 0)
-        {
-            plci.pushConstantRangeCount = 1;
-            plci.pPushConstantRanges = &pcr;
-        }
-
-        pipeline_layout = vmc.logical_device.get().createPipelineLayout(plci);
+        const StageDescription& sd = stage_descriptions[0];
+        Shader shader(vmc.logical_device.get(), sd.shader_name, vk::ShaderStageFlagBits::eCompute);
+        vk::SpecializationInfo spec_info(sd.spec_entries.size(), sd.spec_entries.data(), sd.spec_data.size(), sd.spec_data.data());
 
         vk::PipelineShaderStageCreateInfo pssci = shader.get_stage_create_info();
-        pssci.pSpecializationInfo = &shader_info.spec_info;
+        pssci.pSpecializationInfo = &spec_info;
 
         vk::ComputePipelineCreateInfo cpci{};
         cpci.sType = vk::StructureType::eComputePipelineCreateInfo;
         cpci.stage = pssci;
         cpci.layout = pipeline_layout;
 
-        vk::ResultValue<vk::Pipeline> comute_pipeline_result_value = vmc.logical_device.get().createComputePipeline(VK_NULL_HANDLE, cpci);
+        vk::ResultValue<vk::Pipeline> comute_pipeline_result_value = vmc.logical_device.get().createComputePipeline(vmc.pipeline_cache.get(), cpci);
         VE_CHECK(comute_pipeline_result_value.result, "Failed to create compute pipeline!");
         pipeline = comute_pipeline_result_value.value;
 
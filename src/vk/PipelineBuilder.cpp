@@ -0,0 +1,45 @@
+#include "vk/PipelineBuilder.hpp"
+
+#include <atomic>
+#include <exception>
+#include <thread>
+
+#include "ve_log.hpp"
+
+namespace ve
+{
+    void PipelineBuilder::add(Pipeline& pipeline)
+    {
+        pipelines.push_back(&pipeline);
+    }
+
+    void PipelineBuilder::build()
+    {
+        if (pipelines.empty()) return;
+        const uint32_t thread_count = std::min<uint32_t>(std::max(1u, std::thread::hardware_concurrency()), pipelines.size());
+        std::atomic<uint32_t> next_idx = 0;
+        // exceptions cannot leave a thread, so the first one is rethrown after all threads are joined
+        std::exception_ptr exception;
+        std::atomic_flag exception_set = ATOMIC_FLAG_INIT;
+        auto work = [&]() -> void {
+            for (uint32_t i = next_idx++; i < pipelines.size(); i = next_idx++)
+            {
+                try
+                {
+                    pipelines[i]->build();
+                }
+                catch (...)
+                {
+                    if (!exception_set.test_and_set()) exception = std::current_exception();
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < thread_count; ++i) threads.emplace_back(work);
+        work();
+        for (auto& thread : threads) thread.join();
+        spdlog::debug("Built {} pipelines on {} threads", pipelines.size(), thread_count);
+        pipelines.clear();
+        if (exception) std::rethrow_exception(exception);
+    }
+} // namespace ve
@@ -0,0 +1,84 @@
+#include "vk/PipelineCache.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+#include "ve_log.hpp"
+
+namespace ve
+{
+    PipelineCache::PipelineCache(const PhysicalDevice& physical_device, const LogicalDevice& logical_device) : logical_device(logical_device), properties(physical_device.get().getProperties())
+    {
+        filename = std::format("../cache/pipeline_cache_{:04x}_{:04x}_", properties.vendorID, properties.deviceID);
+        for (uint8_t byte : properties.pipelineCacheUUID) filename += std::format("{:02x}", byte);
+        filename += ".bin";
+
+        std::vector<char> cache_data = load_cache_data();
+        vk::PipelineCacheCreateInfo pcci{};
+        pcci.sType = vk::StructureType::ePipelineCacheCreateInfo;
+        pcci.initialDataSize = cache_data.size();
+        pcci.pInitialData = cache_data.data();
+        pipeline_cache = logical_device.get().createPipelineCache(pcci);
+        spdlog::info("Created pipeline cache with {} bytes of initial data", cache_data.size());
+    }
+
+    void PipelineCache::self_destruct()
+    {
+        save_cache_data();
+        logical_device.get().destroyPipelineCache(pipeline_cache);
+    }
+
+    const vk::PipelineCache& PipelineCache::get() const
+    {
+        return pipeline_cache;
+    }
+
+    std::vector<char> PipelineCache::load_cache_data() const
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) return {};
+        std::vector<char> data(file.tellg());
+        file.seekg(0);
+        file.read(data.data(), data.size());
+        // some drivers do not validate the initial data, so only use data that was created by the same device and driver
+        VkPipelineCacheHeaderVersionOne header;
+        if (!file.good() || data.size() < sizeof(header))
+        {
+            spdlog::warn("Ignoring truncated pipeline cache \"{}\"", filename);
+            return {};
+        }
+        memcpy(&header, data.data(), sizeof(header));
+        if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || header.vendorID != properties.vendorID || header.deviceID != properties.deviceID || memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0)
+        {
+            spdlog::warn("Ignoring pipeline cache \"{}\" of different device or driver", filename);
+            return {};
+        }
+        return data;
+    }
+
+    void PipelineCache::save_cache_data() const
+    {
+        std::vector<uint8_t> data = logical_device.get().getPipelineCacheData(pipeline_cache);
+        std::filesystem::path path(filename);
+        std::filesystem::create_directories(path.parent_path());
+        // write to a temporary file first that a crash while writing does not leave a broken cache behind
+        std::filesystem::path tmp_path(filename + ".tmp");
+        {
+            std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                spdlog::warn("Failed to open pipeline cache \"{}\" for writing", tmp_path.string());
+                return;
+            }
+            file.write(reinterpret_cast<const char*>(data.data()), data.size());
+            if (!file.good())
+            {
+                spdlog::warn("Failed to write pipeline cache \"{}\"", tmp_path.string());
+                return;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, path, ec);
+        if (ec) spdlog::warn("Failed to replace pipeline cache \"{}\": {}", filename, ec.message());
+    }
+} // namespace ve
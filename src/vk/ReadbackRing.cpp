@@ -0,0 +1,88 @@
+#include "vk/ReadbackRing.hpp"
+
+namespace ve
+{
+    ReadbackHandle::ReadbackHandle(const ReadbackRing* ring, uint32_t frame_idx, uint64_t serial, vk::DeviceSize offset, vk::DeviceSize byte_count) : ring(ring), frame_idx(frame_idx), serial(serial), offset(offset), byte_count(byte_count)
+    {}
+
+    bool ReadbackHandle::is_valid() const
+    {
+        return ring != nullptr;
+    }
+
+    bool ReadbackHandle::is_ready() const
+    {
+        return ring != nullptr && ring->is_complete(frame_idx, serial);
+    }
+
+    void ReadbackHandle::get_bytes(void* data, vk::DeviceSize count) const
+    {
+        VE_ASSERT(is_ready(), "Readback is not ready yet!");
+        VE_ASSERT(count <= byte_count, "Cannot get more bytes than were read back!");
+        ring->read(data, offset, count);
+    }
+
+    ReadbackRing::ReadbackRing(const VulkanMainContext& vmc, vk::DeviceSize frame_byte_size) : vmc(vmc), frame_byte_size(frame_byte_size)
+    {
+        offsets.fill(0);
+        serials.fill(1);
+        completed_serials.fill(0);
+
+        vk::BufferCreateInfo bci{};
+        bci.sType = vk::StructureType::eBufferCreateInfo;
+        bci.size = frame_byte_size * frames_in_flight;
+        bci.usage = vk::BufferUsageFlagBits::eTransferDst;
+        bci.sharingMode = vk::SharingMode::eExclusive;
+        VmaAllocationCreateInfo vaci{};
+        vaci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+        vaci.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        VkBuffer local_buffer;
+        VmaAllocationInfo vai;
+        VE_CHECK(vk::Result(vmaCreateBuffer(vmc.va, (VkBufferCreateInfo*) (&bci), &vaci, &local_buffer, &vmaa, &vai)), "Failed to create readback ring!");
+        buffer = vk::Buffer(local_buffer);
+        mapped_mem = static_cast<uint8_t*>(vai.pMappedData);
+    }
+
+    void ReadbackRing::self_destruct()
+    {
+        vmaDestroyBuffer(vmc.va, buffer, vmaa);
+    }
+
+    void ReadbackRing::begin_frame(uint32_t frame_idx)
+    {
+        completed_serials[frame_idx] = serials[frame_idx];
+        serials[frame_idx]++;
+        offsets[frame_idx] = 0;
+    }
+
+    vk::DeviceSize ReadbackRing::allocate(uint32_t frame_idx, vk::DeviceSize byte_count)
+    {
+        // keep every readback aligned for the structs that are copied into the ring
+        const vk::DeviceSize offset = (offsets[frame_idx] + 15) & ~vk::DeviceSize(15);
+        VE_ASSERT(offset + byte_count <= frame_byte_size, "Readback ring region of frame {} is full!", frame_idx);
+        offsets[frame_idx] = offset + byte_count;
+        return frame_idx * frame_byte_size + offset;
+    }
+
+    uint64_t ReadbackRing::get_serial(uint32_t frame_idx) const
+    {
+        return serials[frame_idx];
+    }
+
+    bool ReadbackRing::is_complete(uint32_t frame_idx, uint64_t serial) const
+    {
+        return completed_serials[frame_idx] >= serial;
+    }
+
+    void ReadbackRing::read(void* data, vk::DeviceSize offset, vk::DeviceSize byte_count) const
+    {
+        // the memory does not need to be host coherent
+        vmaInvalidateAllocation(vmc.va, vmaa, offset, byte_count);
+        memcpy(data, mapped_mem + offset, byte_count);
+    }
+
+    const vk::Buffer& ReadbackRing::get() const
+    {
+        return buffer;
+    }
+} // namespace ve
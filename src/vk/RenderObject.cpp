@@ -23,7 +23,7 @@ namespace ve
         meshes.insert(meshes.end(), mesh_list.begin(), mesh_list.end());
     }
 
-    void RenderObject::construct(const RenderPass& render_pass, const std::vector<ShaderInfo>& shader_infos, bool reload)
+    void RenderObject::construct(const RenderPass& render_pass, const std::vector<ShaderInfo>& shader_infos, PipelineBuilder& pipeline_builder, bool reload)
     {
         if (meshes.empty()) return;
         if (!reload)
@@ -35,13 +35,15 @@ namespace ve
         {
             self_destruct(false);
         }
-        construct_pipelines(render_pass, shader_infos);
+        construct_pipelines(render_pass, shader_infos, pipeline_builder);
     }
 
-    void RenderObject::construct_pipelines(const RenderPass& render_pass, const std::vector<ShaderInfo>& shader_infos)
+    void RenderObject::construct_pipelines(const RenderPass& render_pass, const std::vector<ShaderInfo>& shader_infos, PipelineBuilder& pipeline_builder)
     {
-        pipeline.construct(render_pass, dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eFill, Vertex::get_binding_descriptions(), Vertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(RenderPushConstants))});
-        mesh_view_pipeline.construct(render_pass, dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eLine, Vertex::get_binding_descriptions(), Vertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(RenderPushConstants))});
+        pipeline.describe(render_pass, dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eFill, Vertex::get_binding_descriptions(), Vertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(RenderPushConstants))});
+        pipeline_builder.add(pipeline);
+        mesh_view_pipeline.describe(render_pass, dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eLine, Vertex::get_binding_descriptions(), Vertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(RenderPushConstants))});
+        pipeline_builder.add(mesh_view_pipeline);
     }
 
     void RenderObject::draw(vk::CommandBuffer& cb, GameState& gs)
@@ -43,9 +43,10 @@ namespace ve
 
         dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
         dependencies[0].dstSubpass = 0;
-        dependencies[0].srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
+        // the depth buffer may alias the deferred depth buffer, so also wait for depth writes of the deferred pass
+        dependencies[0].srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
         dependencies[0].dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
-        dependencies[0].srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+        dependencies[0].srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
         dependencies[0].dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
         dependencies[0].dependencyFlags = vk::DependencyFlagBits::eByRegion;
 
@@ -71,7 +72,8 @@ namespace ve
         {
             attachments[i].samples = vk::SampleCountFlagBits::e1;
             attachments[i].loadOp = vk::AttachmentLoadOp::eClear;
-            attachments[i].storeOp = vk::AttachmentStoreOp::eStore;
+            // depth is not needed after the pass
+            attachments[i].storeOp = i == attachments.size() - 1 ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore;
             attachments[i].stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
             attachments[i].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
             attachments[i].initialLayout = vk::ImageLayout::eUndefined;
@@ -102,7 +104,7 @@ namespace ve
         subpass.colorAttachmentCount = color_references.size();
         subpass.pDepthStencilAttachment = &depth_reference;
 
-        std::array<vk::SubpassDependency, 2> dependencies;
+        std::array<vk::SubpassDependency, 3> dependencies;
 
         dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
         dependencies[0].dstSubpass = 0;
@@ -120,6 +122,15 @@ namespace ve
         dependencies[1].dstAccessMask = vk::AccessFlagBits::eMemoryRead;
         dependencies[1].dependencyFlags = vk::DependencyFlagBits::eByRegion;
 
+        // the depth buffer may alias the depth buffer of the lighting passes of the previous frame
+        dependencies[2].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[2].dstSubpass = 0;
+        dependencies[2].srcStageMask = vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+        dependencies[2].dstStageMask = vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+        dependencies[2].srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+        dependencies[2].dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+        dependencies[2].dependencyFlags = vk::DependencyFlagBits::eByRegion;
+
         vk::RenderPassCreateInfo rpci;
         rpci.pAttachments = attachments.data();
         rpci.attachmentCount = attachments.size();
@@ -11,22 +11,25 @@
 
 namespace ve
 {
-    Scene::Scene(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage) : vmc(vmc), vcc(vcc), storage(storage), tunnel_objects(vmc, vcc, storage), collision_handler(vmc, vcc, storage), path_tracer(vmc, vcc, storage), jp(vmc, vcc, storage)
+    Scene::Scene(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage) : vmc(vmc), vcc(vcc), storage(storage), upload_arena(vmc, storage), tunnel_objects(vmc, vcc, storage, upload_arena), collision_handler(vmc, vcc, storage), path_tracer(vmc, vcc, storage), jp(vmc, vcc, storage, upload_arena)
     {}
 
-    void Scene::construct(const RenderPass& render_pass)
+    void Scene::construct(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
         if (!loaded) VE_THROW("Cannot construct scene before loading one!");
         mesh_render_data_buffer = storage.add_named_buffer("mesh_render_data", mesh_render_data, vk::BufferUsageFlagBits::eStorageBuffer, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.graphics);
+        upload_arena.create_buffers(upload_arena_frame_size);
         tunnel_objects.create_buffers(path_tracer);
         jp.create_buffers();
         vk::CommandBuffer& cb = vcc.begin(vcc.compute_cb[0]);
         path_tracer.create_tlas(cb, 0);
         path_tracer.create_tlas(cb, 1);
         vcc.submit_compute(cb, true);
+        // scratch memory of the initial tunnel blas builds
+        path_tracer.release_retired_scratch_buffers();
         // initialize tunnel
-        tunnel_objects.construct(render_pass);
-        collision_handler.construct(render_pass);
+        tunnel_objects.construct(render_pass, pipeline_builder);
+        collision_handler.construct(render_pass, pipeline_builder);
         // add one uniform buffer and descriptor set for each frame as the uniform buffer is changed in every frame
         for (uint32_t i = 0; i < frames_in_flight; ++i)
         {
@@ -63,39 +66,41 @@ namespace ve
             ros.at(ShaderFlavor::Emissive).dsh.new_set();
             ros.at(ShaderFlavor::Emissive).dsh.add_descriptor(0, storage.get_buffer(model_render_data_buffers.back()));
             ros.at(ShaderFlavor::Emissive).dsh.add_descriptor(1, storage.get_buffer(mesh_render_data_buffer));
-            if (material_buffer > -1) ros.at(ShaderFlavor::Emissive).dsh.add_descriptor(3, storage.get_buffer(material_buffer));
+            if (material_buffer.is_valid()) ros.at(ShaderFlavor::Emissive).dsh.add_descriptor(3, storage.get_buffer(material_buffer));
             ros.at(ShaderFlavor::Emissive).dsh.add_descriptor(90, storage.get_buffer_by_name("frame_data_" + std::to_string(i)));
         }
         Mesh spawn_mesh;
         if (!ros.at(ShaderFlavor::Emissive).get_mesh("Engine_Lights", spawn_mesh)) VE_THROW("Failed to find desired spawn mesh for particles!");
-        jp.construct(render_pass, spawn_mesh, model_render_data_buffers, mesh_render_data[spawn_mesh.mesh_render_data_idx].model_render_data_idx);
-        construct_pipelines(render_pass, false);
+        jp.construct(render_pass, spawn_mesh, model_render_data_buffers, mesh_render_data[spawn_mesh.mesh_render_data_idx].model_render_data_idx, pipeline_builder);
+        construct_pipelines(render_pass, false, pipeline_builder);
     }
 
     void Scene::self_destruct()
     {
         path_tracer.self_destruct();
         jp.self_destruct();
+        upload_arena.self_destruct();
         storage.destroy_buffer(vertex_buffer);
         storage.destroy_buffer(index_buffer);
         storage.destroy_buffer(mesh_render_data_buffer);
-        if (material_buffer > -1) storage.destroy_buffer(material_buffer);
-        material_buffer = -1;
-        for (int32_t& light_buffer : light_buffers)
+        if (material_buffer.is_valid()) storage.destroy_buffer(material_buffer);
+        material_buffer = BufferHandle();
+        for (BufferHandle& light_buffer : light_buffers)
         {
-            if (light_buffer > -1) storage.destroy_buffer(light_buffer);
-            light_buffer = -1;
+            if (light_buffer.is_valid()) storage.destroy_buffer(light_buffer);
+            light_buffer = BufferHandle();
         }
         lights.clear();
         initial_light_values.clear();
-        for (auto& b : bb_mm_buffers) storage.get_buffer(b).self_destruct();
-        for (auto& b : frame_data_buffers) storage.get_buffer(b).self_destruct();
+        for (auto& b : bb_mm_buffers) storage.destroy_buffer(b);
+        for (auto& b : frame_data_buffers) storage.destroy_buffer(b);
         bb_mm_buffers.clear();
+        frame_data_buffers.clear();
         for (auto& buffer : model_render_data_buffers) storage.destroy_buffer(buffer);
         model_render_data_buffers.clear();
         model_render_data.clear();
-        if (texture_image > -1) storage.destroy_image(texture_image);
-        texture_image = -1;
+        if (texture_image.is_valid()) storage.destroy_image(texture_image);
+        texture_image = ImageHandle();
         for (auto& ro : ros) ro.second.self_destruct();
         ros.clear(); 
         model_handles.clear();
@@ -105,7 +110,7 @@ namespace ve
         collision_handler.self_destruct();
     }
 
-    void Scene::construct_pipelines(const RenderPass& render_pass, bool reload)
+    void Scene::construct_pipelines(const RenderPass& render_pass, bool reload, PipelineBuilder& pipeline_builder)
     {
         vk::SpecializationMapEntry model_render_data_buffer_size_entry(0, 0, sizeof(uint32_t));
         uint32_t model_render_data_buffer_size = model_render_data.size();
@@ -121,19 +126,19 @@ namespace ve
         vk::SpecializationInfo fragment_spec_info(fragment_entries.size(), fragment_entries.data(), sizeof(uint32_t) * fragment_entries_data.size(), fragment_entries_data.data());
 
         shader_infos[1] = ShaderInfo{"default.frag", vk::ShaderStageFlagBits::eFragment, fragment_spec_info};
-        ros.at(ShaderFlavor::Default).construct(render_pass, shader_infos, reload);
+        ros.at(ShaderFlavor::Default).construct(render_pass, shader_infos, pipeline_builder, reload);
         shader_infos[1] = ShaderInfo{"basic.frag", vk::ShaderStageFlagBits::eFragment, fragment_spec_info};
-        ros.at(ShaderFlavor::Basic).construct(render_pass, shader_infos, reload);
+        ros.at(ShaderFlavor::Basic).construct(render_pass, shader_infos, pipeline_builder, reload);
         shader_infos[0] = ShaderInfo("emissive.vert", vk::ShaderStageFlagBits::eVertex, model_render_spec_info);
         shader_infos[1] = ShaderInfo{"emissive.frag", vk::ShaderStageFlagBits::eFragment};
-        ros.at(ShaderFlavor::Emissive).construct(render_pass, shader_infos, reload);
+        ros.at(ShaderFlavor::Emissive).construct(render_pass, shader_infos, pipeline_builder, reload);
     }
 
-    void Scene::reload_shaders(const RenderPass& render_pass)
+    void Scene::reload_shaders(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
-        construct_pipelines(render_pass, true);
-        tunnel_objects.reload_shaders(render_pass);
-        collision_handler.reload_shaders(render_pass);
+        construct_pipelines(render_pass, true, pipeline_builder);
+        tunnel_objects.reload_shaders(render_pass, pipeline_builder);
+        collision_handler.reload_shaders(render_pass, pipeline_builder);
     }
 
     void Scene::load(const std::string& path)
@@ -263,10 +268,13 @@ namespace ve
         {
             ModelInfo& mi = model_infos[i];
             uint32_t mask = mi.name == "Player" ? 0xFE : 0xFF;
-            mi.blas_idx = path_tracer.add_blas(cb, vertex_buffer, index_buffer, mi.mesh_index_offsets, mi.mesh_index_count, sizeof(Vertex));
+            // scene geometry never changes, only the instance transforms move
+            mi.blas_idx = path_tracer.add_blas(cb, vertex_buffer, index_buffer, mi.mesh_index_offsets, mi.mesh_index_count, sizeof(Vertex), true);
             mi.instance_idx = path_tracer.add_instance(mi.blas_idx, model_render_data[i].M, i, mask);
         }
         vcc.submit_compute(cb, true);
+        path_tracer.compact_static_blas();
+        path_tracer.release_retired_scratch_buffers();
         if (!materials.empty())
         {
             material_buffer = storage.add_named_buffer(std::string("materials"), materials, vk::BufferUsageFlagBits::eStorageBuffer, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.graphics);
@@ -345,7 +353,7 @@ namespace ve
         return ros.at(flavor).dsh;
     }
 
-    void Scene::restart()
+    void Scene::restart(uint32_t seed)
     {
         for (auto& d : model_render_data)
         {
@@ -353,7 +361,7 @@ namespace ve
             d.segment_uid = 0;
         }
         collision_handler.reset_all_shader_return_values();
-        tunnel_objects.restart(path_tracer);
+        tunnel_objects.restart(path_tracer, seed);
     }
 
     void Scene::draw(vk::CommandBuffer& cb, GameState& gs, DeviceTimer& timer)
@@ -372,8 +380,9 @@ namespace ve
         if (gs.game_data.show_player) jp.draw(cb, gs);
     }
 
-    void Scene::update_game_state(vk::CommandBuffer& cb, GameState& gs, DeviceTimer& timer)
+    void Scene::update_game_state(vk::CommandBuffer& cb, GameState& gs, DeviceTimer& timer, ReadbackRing& readback_ring)
     {
+        upload_arena.begin_frame(gs.game_data.current_frame);
         uint32_t player_idx = model_handles.at("Player");
         glm::mat4 vp = gs.cam.getVP();
         // let camera follow the players object
@@ -414,11 +423,12 @@ namespace ve
         tunnel_objects.advance(gs, timer, path_tracer);
         FrameData frame_data{gs.game_data.player_data.pos, gs.game_data.player_data.dir, gs.game_data.player_data.up, gs.game_data.player_data.segment_id, gs.game_data.time_diff, gs.game_data.time, gs.game_data.first_segment_indices_idx, gs.settings.color_view, gs.settings.normal_view, gs.settings.tex_view, gs.settings.segment_uid_view};
         storage.get_buffer(frame_data_buffers[gs.game_data.current_frame]).update_data(frame_data);
-        collision_handler.compute(gs.game_data.current_frame, timer);
+        collision_handler.compute(gs.game_data.current_frame, timer, readback_ring, tunnel_objects.get_first_segment_uid());
 
         if (!lights.empty()) storage.get_buffer(light_buffers[gs.game_data.current_frame]).update_data(lights);
         storage.get_buffer(model_render_data_buffers[gs.game_data.current_frame]).update_data(model_render_data);
         // handle collision: reset ship and let it blink for 3s
+        // the results are the ones of the last computation of this frame as they are read back without waiting
         gs.game_data.collision_results = collision_handler.get_collision_results(gs.game_data.current_frame);
         // check if player tries to move in the wrong direction
         if (!tunnel_objects.is_pos_past_segment(gs.game_data.player_data.pos, std::max(gs.game_data.player_data.segment_id - 1, 0u), true)) gs.game_data.collision_results.collision_detected = 1;
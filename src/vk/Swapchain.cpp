@@ -42,14 +42,25 @@ namespace ve
         extent = choose_extent();
         surface_format = choose_surface_format();
         swapchain = create_swapchain();
-        depth_buffer = storage.add_image(extent.width, extent.height, vk::ImageUsageFlagBits::eDepthStencilAttachment, depth_format, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics});
-        deferred_depth_buffer = storage.add_image(extent.width, extent.height, vk::ImageUsageFlagBits::eDepthStencilAttachment, depth_format, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics});
+        // the depth buffers are cleared at the start of their render pass and never stored, the deferred pass is finished before the lighting passes begin
+        // the g-buffer images are sampled by the lighting passes and need their own memory
+        if (supports_lazily_allocated_memory())
+        {
+            depth_buffer = storage.add_image(extent.width, extent.height, vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eTransientAttachment, depth_format, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics});
+            deferred_depth_buffer = storage.add_image(extent.width, extent.height, vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eTransientAttachment, depth_format, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics});
+        }
+        else
+        {
+            // lifetimes of the depth buffers do not overlap, so they share one allocation
+            depth_buffer = storage.add_image(extent.width, extent.height, vk::ImageUsageFlagBits::eDepthStencilAttachment, depth_format, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics});
+            deferred_depth_buffer = storage.add_image(storage.get_image(depth_buffer).get_allocation(), extent.width, extent.height, vk::ImageUsageFlagBits::eDepthStencilAttachment, depth_format, std::vector<uint32_t>{vmc.queue_family_indices.graphics});
+        }
         deferred_images.push_back(storage.add_named_image("deferred_position", extent.width, extent.height, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::Format::eR32G32B32A32Sfloat, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics}));
         deferred_images.push_back(storage.add_named_image("deferred_normal", extent.width, extent.height, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::Format::eR16G16B16A16Sfloat, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics}));
         deferred_images.push_back(storage.add_named_image("deferred_color", extent.width, extent.height, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::Format::eR8G8B8A8Unorm, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics}));
         deferred_images.push_back(storage.add_named_image("deferred_segment_uid", extent.width, extent.height, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::Format::eR32Sint, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics}));
         deferred_images.push_back(storage.add_named_image("deferred_motion", extent.width, extent.height, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::Format::eR32G32Sfloat, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics}));
-        for (uint32_t i : deferred_images) storage.get_image(i).transition_image_layout(vcc, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands, vk::AccessFlagBits::eNone, vk::AccessFlagBits::eNone);
+        for (ImageHandle i : deferred_images) storage.get_image(i).transition_image_layout(vcc, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands, vk::AccessFlagBits::eNone, vk::AccessFlagBits::eNone);
         create_framebuffers();
     }
 
@@ -138,7 +149,7 @@ namespace ve
 
         deferred_framebuffer = vmc.logical_device.get().createFramebuffer(fbci);
 
-        for (uint32_t i : deferred_images)
+        for (ImageHandle i : deferred_images)
         {
             storage.get_image(i).create_sampler(vk::Filter::eNearest, vk::SamplerAddressMode::eClampToEdge, false);
         }
@@ -151,9 +162,10 @@ namespace ve
         vmc.logical_device.get().destroyFramebuffer(deferred_framebuffer);
         for (auto& image_view : image_views) vmc.logical_device.get().destroyImageView(image_view);
         image_views.clear();
-        storage.destroy_image(depth_buffer);
+        // the deferred depth buffer might alias the memory of the depth buffer
         storage.destroy_image(deferred_depth_buffer);
-        for (uint32_t i : deferred_images) storage.destroy_image(i);
+        storage.destroy_image(depth_buffer);
+        for (ImageHandle i : deferred_images) storage.destroy_image(i);
         deferred_images.clear();
         vmc.logical_device.get().destroySwapchainKHR(swapchain);
         if (full)
@@ -222,10 +234,21 @@ namespace ve
         VE_THROW("Failed to find supported format!");
     }
 
+    bool Swapchain::supports_lazily_allocated_memory() const
+    {
+        // usually only available on tiled gpus that keep attachments in on-chip memory
+        vk::PhysicalDeviceMemoryProperties memory_properties = vmc.physical_device.get().getMemoryProperties();
+        for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i)
+        {
+            if (memory_properties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated) return true;
+        }
+        return false;
+    }
+
     void Swapchain::save_screenshot(VulkanCommandContext& vcc, uint32_t image_idx, uint32_t current_frame)
     {
         vk::Image& src_image = images[image_idx];
-        uint32_t dst_image = storage.add_image(extent.width, extent.height, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc, surface_format.format, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics, vmc.queue_family_indices.transfer}, false);
+        ImageHandle dst_image = storage.add_image(extent.width, extent.height, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc, surface_format.format, vk::SampleCountFlagBits::e1, false, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics, vmc.queue_family_indices.transfer}, false);
 
         vk::CommandBuffer& cb = vcc.begin(vcc.graphics_cb[current_frame]);
         perform_image_layout_transition(cb, storage.get_image(dst_image).get_image(), vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eNone, vk::AccessFlagBits::eTransferWrite, 0, 1, 1);
@@ -238,6 +261,6 @@ namespace ve
         vcc.submit_graphics(cb, true);
 
         storage.get_image(dst_image).save_to_file();
-        storage.get_image(dst_image).self_destruct();
+        storage.destroy_image(dst_image);
     }
 } // namespace ve
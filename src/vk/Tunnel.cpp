@@ -7,7 +7,7 @@
 
 namespace ve
 {
-    Tunnel::Tunnel(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage) : skybox_dsh(vmc), render_dsh(vmc), vmc(vmc), vcc(vcc), storage(storage), skybox_render_pipeline(vmc), pipeline(vmc), mesh_view_pipeline(vmc)
+    Tunnel::Tunnel(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage, UploadArena& upload_arena) : skybox_dsh(vmc), render_dsh(vmc), vmc(vmc), vcc(vcc), storage(storage), upload_arena(upload_arena), skybox_render_pipeline(vmc), pipeline(vmc), mesh_view_pipeline(vmc)
     {}
 
     void Tunnel::self_destruct(bool full)
@@ -17,8 +17,6 @@ namespace ve
         mesh_view_pipeline.self_destruct();
         render_dsh.self_destruct();
         storage.destroy_image(noise_textures);
-        for (auto i : model_render_data_buffers) storage.destroy_buffer(i);
-        model_render_data_buffers.clear();
         if (full)
         {
             skybox_dsh.self_destruct();
@@ -26,6 +24,9 @@ namespace ve
             storage.destroy_image(skybox_texture);
             storage.destroy_buffer(vertex_buffer);
             storage.destroy_buffer(index_buffer);
+            storage.destroy_buffer(collision_vertex_buffer);
+            storage.destroy_buffer(collision_index_buffer);
+            storage.destroy_buffer(ring_radii_buffer);
         }
     }
 
@@ -34,37 +35,15 @@ namespace ve
         skybox_texture = storage.add_named_image("skybox_texture", "../assets/textures/tunnel_skybox_texture.png", true, 0, std::vector<uint32_t>{vmc.queue_family_indices.graphics, vmc.queue_family_indices.transfer}, vk::ImageUsageFlagBits::eSampled);
         // double space is needed to enable that new vertices can replace old ones as the tunnel continuously moves forward
         std::vector<TunnelVertex> vertices(vertex_count * 2);
-        std::vector<uint32_t> indices(index_count * 2);
-        // write indices in advance even for the currently unused space that is reserved for the FixVector behavior
-        for (uint32_t i = 0; i < segment_count * 2; ++i)
-        {
-            for (uint32_t j = 0; j < samples_per_segment - 1; ++j)
-            {
-                for (uint32_t k = 0; k < vertices_per_sample - 1; ++k)
-                {
-                    // iterate over all vertices and add 2 triangles per vertex to build the quad that lies in direction of the circle and to the next sample circle
-                    const uint32_t indices_idx = i * indices_per_segment + j * vertices_per_sample * 6 + k * 6;
-                    const uint32_t vertices_idx = i * samples_per_segment * vertices_per_sample + j * vertices_per_sample + k;
-                    indices[indices_idx] = vertices_idx;
-                    indices[indices_idx + 1] = vertices_idx + 1;
-                    indices[indices_idx + 2] = vertices_idx + vertices_per_sample;
-                    indices[indices_idx + 3] = vertices_idx + 1;
-                    indices[indices_idx + 4] = vertices_idx + vertices_per_sample + 1;
-                    indices[indices_idx + 5] = vertices_idx + vertices_per_sample;
-                }
-                // close the ring with the last element
-                const uint32_t last_indices_idx = i * indices_per_segment + j * vertices_per_sample * 6 + (vertices_per_sample - 1) * 6;
-                const uint32_t last_vertices_idx = i * samples_per_segment * vertices_per_sample + j * vertices_per_sample + (vertices_per_sample - 1);
-                indices[last_indices_idx] = last_vertices_idx;
-                indices[last_indices_idx + 1] = last_vertices_idx + 1 - vertices_per_sample;
-                indices[last_indices_idx + 2] = last_vertices_idx + vertices_per_sample;
-                indices[last_indices_idx + 3] = last_vertices_idx + 1 - vertices_per_sample;
-                indices[last_indices_idx + 4] = last_vertices_idx + 1;
-                indices[last_indices_idx + 5] = last_vertices_idx + vertices_per_sample;
-            }
-        }
+        std::vector<uint32_t> indices = create_ring_indices(samples_per_segment, vertices_per_sample);
         vertex_buffer = storage.add_named_buffer(std::string("tunnel_vertices"), vertices, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.graphics, vmc.queue_family_indices.compute);
         index_buffer = storage.add_named_buffer(std::string("tunnel_indices"), indices, vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.graphics, vmc.queue_family_indices.compute);
+        // the coarse collision mesh uses the same layout as the render mesh with fewer rings and vertices per ring
+        std::vector<glm::vec4> collision_vertices(collision_vertex_count * 2);
+        std::vector<uint32_t> collision_indices = create_ring_indices(collision_samples_per_segment, collision_vertices_per_sample);
+        collision_vertex_buffer = storage.add_named_buffer(std::string("tunnel_collision_vertices"), collision_vertices, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.compute);
+        collision_index_buffer = storage.add_named_buffer(std::string("tunnel_collision_indices"), collision_indices, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.compute);
+        ring_radii_buffer = storage.add_named_buffer(std::string("tunnel_ring_radii"), segment_count * 2 * collision_samples_per_segment * sizeof(float), vk::BufferUsageFlagBits::eStorageBuffer, true, vmc.queue_family_indices.compute);
         std::vector<TunnelSkyboxVertex> skybox_vertices = {
             TunnelSkyboxVertex{glm::vec3(segment_scale, segment_scale, 0.0), glm::vec2(1.0, 1.0)},
             TunnelSkyboxVertex{glm::vec3(-segment_scale, segment_scale, 0.0), glm::vec2(0.0, 1.0)},
@@ -76,17 +55,17 @@ namespace ve
         skybox_vertex_buffer = storage.add_named_buffer("tunnel_skybox_vertices", skybox_vertices, vk::BufferUsageFlagBits::eVertexBuffer, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.graphics);
     }
 
-    void Tunnel::construct(const RenderPass& render_pass)
+    void Tunnel::construct(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
-        construct_pipelines(render_pass);
+        construct_pipelines(render_pass, pipeline_builder);
     }
 
-    void Tunnel::construct_pipelines(const RenderPass& render_pass)
+    void Tunnel::construct_pipelines(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
         create_noise_textures();
 
         skybox_dsh.add_binding(1, vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eFragment);
-        render_dsh.add_binding(0, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eVertex);
+        render_dsh.add_binding(0, vk::DescriptorType::eUniformBufferDynamic, vk::ShaderStageFlagBits::eVertex);
         render_dsh.add_binding(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment);
         render_dsh.add_binding(2, vk::DescriptorType::eCombinedImageSampler, vk::ShaderStageFlagBits::eFragment);
         render_dsh.add_binding(3, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eFragment);
@@ -99,15 +78,13 @@ namespace ve
         render_dsh.add_binding(13, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eFragment);
         render_dsh.add_binding(90, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eFragment);
 
-        // add one uniform buffer and descriptor set for each frame as the uniform buffer is changed in every frame
+        // one descriptor set for each frame, the model render data is placed in the upload arena of the frame every frame
         for (uint32_t i = 0; i < frames_in_flight; ++i)
         {
-            model_render_data_buffers.push_back(storage.add_buffer(std::vector<ModelRenderData>{mrd}, vk::BufferUsageFlagBits::eUniformBuffer, false, vmc.queue_family_indices.transfer, vmc.queue_family_indices.graphics));
-
             skybox_dsh.new_set();
             skybox_dsh.add_descriptor(1, storage.get_image(skybox_texture));
             render_dsh.new_set();
-            render_dsh.add_descriptor(0, storage.get_buffer(model_render_data_buffers.back()));
+            render_dsh.add_descriptor(0, upload_arena.get_buffer(i), sizeof(ModelRenderData));
             render_dsh.add_descriptor(1, storage.get_buffer_by_name("mesh_render_data"));
             render_dsh.add_descriptor(2, storage.get_image_by_name("textures"));
             render_dsh.add_descriptor(3, storage.get_buffer_by_name("materials"));
@@ -137,18 +114,22 @@ namespace ve
         vk::SpecializationInfo fragment_spec_info(fragment_entries.size(), fragment_entries.data(), sizeof(uint32_t) * fragment_entries_data.size(), fragment_entries_data.data());
         shader_infos[1] = ShaderInfo{"tunnel.frag", vk::ShaderStageFlagBits::eFragment, fragment_spec_info};
 
-        pipeline.construct(render_pass, render_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eFill, TunnelVertex::get_binding_descriptions(), TunnelVertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {});
-        mesh_view_pipeline.construct(render_pass, render_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eLine, TunnelVertex::get_binding_descriptions(), TunnelVertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {});
+        pipeline.describe(render_pass, render_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eFill, TunnelVertex::get_binding_descriptions(), TunnelVertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {});
+
+        pipeline_builder.add(pipeline);
+        mesh_view_pipeline.describe(render_pass, render_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eLine, TunnelVertex::get_binding_descriptions(), TunnelVertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {});
+        pipeline_builder.add(mesh_view_pipeline);
 
         shader_infos[0] = ShaderInfo{"tunnel_skybox.vert", vk::ShaderStageFlagBits::eVertex};
         shader_infos[1] = ShaderInfo{"tunnel_skybox.frag", vk::ShaderStageFlagBits::eFragment};
-        skybox_render_pipeline.construct(render_pass, skybox_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eFill, TunnelSkyboxVertex::get_binding_descriptions(), TunnelSkyboxVertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(TunnelSkyboxPushConstants))});
+        skybox_render_pipeline.describe(render_pass, skybox_dsh.get_layouts()[0], shader_infos, vk::PolygonMode::eFill, TunnelSkyboxVertex::get_binding_descriptions(), TunnelSkyboxVertex::get_attribute_descriptions(), vk::PrimitiveTopology::eTriangleList, {vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(TunnelSkyboxPushConstants))});
+        pipeline_builder.add(skybox_render_pipeline);
     }
 
-    void Tunnel::reload_shaders(const RenderPass& render_pass)
+    void Tunnel::reload_shaders(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
         self_destruct(false);
-        construct_pipelines(render_pass);
+        construct_pipelines(render_pass, pipeline_builder);
     }
 
     // https://gist.github.com/kevinmoran/b45980723e53edeb8a5a43c49f134724
@@ -169,10 +150,10 @@ namespace ve
         cb.bindIndexBuffer(storage.get_buffer(index_buffer).get(), 0, vk::IndexType::eUint32);
         mrd.prev_MVP = mrd.MVP;
         mrd.MVP = gs.cam.getVP();
-        storage.get_buffer(model_render_data_buffers[gs.game_data.current_frame]).update_data(std::vector<ModelRenderData>{mrd});
+        const uint32_t mrd_offset = upload_arena.upload(gs.game_data.current_frame, mrd);
         const vk::PipelineLayout& pipeline_layout = gs.settings.mesh_view ? mesh_view_pipeline.get_layout() : pipeline.get_layout();
         cb.bindPipeline(vk::PipelineBindPoint::eGraphics, gs.settings.mesh_view ? mesh_view_pipeline.get() : pipeline.get());
-        cb.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout, 0, render_dsh.get_sets()[gs.game_data.current_frame], {});
+        cb.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout, 0, render_dsh.get_sets()[gs.game_data.current_frame], mrd_offset);
         cb.drawIndexed(index_count, 1, gs.game_data.first_segment_indices_idx, 0, 0);
 
         cb.bindVertexBuffers(0, storage.get_buffer(skybox_vertex_buffer).get(), {0});
@@ -185,6 +166,42 @@ namespace ve
         cb.draw(6, 1, 0, 0);
     }
 
+    std::vector<uint32_t> Tunnel::create_ring_indices(uint32_t samples, uint32_t vertices)
+    {
+        const uint32_t indices_per_ring_segment = (samples - 1) * vertices * 6;
+        // double space is needed to enable that new vertices can replace old ones as the tunnel continuously moves forward
+        std::vector<uint32_t> indices(indices_per_ring_segment * segment_count * 2);
+        // write indices in advance even for the currently unused space that is reserved for the FixVector behavior
+        for (uint32_t i = 0; i < segment_count * 2; ++i)
+        {
+            for (uint32_t j = 0; j < samples - 1; ++j)
+            {
+                for (uint32_t k = 0; k < vertices - 1; ++k)
+                {
+                    // iterate over all vertices and add 2 triangles per vertex to build the quad that lies in direction of the circle and to the next sample circle
+                    const uint32_t indices_idx = i * indices_per_ring_segment + j * vertices * 6 + k * 6;
+                    const uint32_t vertices_idx = i * samples * vertices + j * vertices + k;
+                    indices[indices_idx] = vertices_idx;
+                    indices[indices_idx + 1] = vertices_idx + 1;
+                    indices[indices_idx + 2] = vertices_idx + vertices;
+                    indices[indices_idx + 3] = vertices_idx + 1;
+                    indices[indices_idx + 4] = vertices_idx + vertices + 1;
+                    indices[indices_idx + 5] = vertices_idx + vertices;
+                }
+                // close the ring with the last element
+                const uint32_t last_indices_idx = i * indices_per_ring_segment + j * vertices * 6 + (vertices - 1) * 6;
+                const uint32_t last_vertices_idx = i * samples * vertices + j * vertices + (vertices - 1);
+                indices[last_indices_idx] = last_vertices_idx;
+                indices[last_indices_idx + 1] = last_vertices_idx + 1 - vertices;
+                indices[last_indices_idx + 2] = last_vertices_idx + vertices;
+                indices[last_indices_idx + 3] = last_vertices_idx + 1 - vertices;
+                indices[last_indices_idx + 4] = last_vertices_idx + 1;
+                indices[last_indices_idx + 5] = last_vertices_idx + vertices;
+            }
+        }
+        return indices;
+    }
+
     void Tunnel::create_noise_textures()
     {
         constexpr uint32_t noise_texture_dim = 2048;
@@ -0,0 +1,125 @@
+#include "vk/TunnelBezierPoints.hpp"
+#include <cmath>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include "vk/TunnelConstants.hpp"
+
+namespace ve
+{
+    TunnelBezierPoints::TunnelBezierPoints(uint32_t seed) : points(segment_count * 2 + 1), rnd(seed), dis(0.0f, 1.0f)
+    {
+        reset();
+    }
+
+    void TunnelBezierPoints::reset()
+    {
+        queue = std::queue<glm::vec3>();
+        newest.uid = 0;
+        newest.p0 = glm::vec3(0.0f, 0.0f, segment_scale * player_local_segment_position + 1.0f);
+        newest.p1 = newest.p0 - glm::vec3(0.0f, 0.0f, segment_scale / 2.0f);
+        newest.p2 = newest.p0 - glm::vec3(0.0f, 0.0f, segment_scale);
+        for (uint32_t i = 1; i < player_local_segment_position; ++i) queue.push(glm::vec3(newest.p0 - glm::vec3(0.0f, 0.0f, segment_scale * (i + 1))));
+        points[0] = newest.p0;
+        points[1] = newest.p1;
+        points[2] = newest.p2;
+    }
+
+    void TunnelBezierPoints::reset(uint32_t seed)
+    {
+        rnd.seed(seed);
+        reset();
+    }
+
+    void TunnelBezierPoints::add_segment()
+    {
+        newest.uid++;
+        newest.p1 = newest.p2 + newest.p2 - newest.p1;
+        newest.p0 = newest.p2;
+        newest.p2 = pop_queue();
+        points[(newest.uid * 2 + 1) % points.size()] = newest.p1;
+        points[(newest.uid * 2 + 2) % points.size()] = newest.p2;
+    }
+
+    const BezierSegment& TunnelBezierPoints::get_newest_segment() const
+    {
+        return newest;
+    }
+
+    glm::vec3& TunnelBezierPoints::get_point(uint32_t segment_id, uint32_t bezier_point_idx, bool use_global_id)
+    {
+        // convert local id to global such that the modulo operator yields the correct idx
+        if (!use_global_id) segment_id = (segment_id + newest.uid - segment_count + 1);
+        return points[(segment_id * 2 + bezier_point_idx) % points.size()];
+    }
+
+    const std::vector<glm::vec3, boost::alignment::aligned_allocator<glm::vec3, 16>>& TunnelBezierPoints::get_points() const
+    {
+        return points;
+    }
+
+    glm::vec3 TunnelBezierPoints::random_cosine(const glm::vec3& normal, const float cosine_weight)
+    {
+        float theta = std::acos(std::pow(1.0f - std::abs(dis(rnd)), 1.0f / (1.0f + cosine_weight)));
+        float phi = 2.0f * M_PIf * dis(rnd);
+        glm::vec3 up = abs(normal.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
+        glm::vec3 bitangent = glm::cross(normal, tangent);
+
+        glm::vec3 sample = glm::vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+        return glm::normalize(tangent * sample.x + bitangent * sample.y + normal * sample.z);
+    }
+
+    glm::vec3 TunnelBezierPoints::pop_queue()
+    {
+        // no more Bézier points left, create either a long curve or a small segment
+        if (queue.empty())
+        {
+            // high probability for small segment leads to areas with small curvy segments and single long curves
+            const uint32_t random_weight = dis(rnd) < 0.98f ? 1 : 16;
+            glm::vec3 p2 = newest.p0 + segment_scale * random_weight * random_cosine(glm::normalize(newest.p1 - newest.p0), -2.0f * random_weight + 42.0);
+            glm::vec3 p1 = newest.p0 + (newest.p1 - newest.p0) * float(random_weight);
+            for (uint32_t i = 0; i < random_weight; ++i)
+            {
+                const float t = float(i + 1) / float(random_weight);
+                queue.push(std::pow(1 - t, 2.0f) * newest.p0 + (2 - 2 * t) * t * p1 + std::pow(t, 2.0f) * p2);
+            }
+        }
+        glm::vec3 p = queue.front();
+        queue.pop();
+        return p;
+    }
+
+    bool TunnelBezierPoints::is_pos_past_segment(const glm::vec3& pos, uint32_t idx, bool use_global_id)
+    {
+        return glm::dot(glm::normalize(pos - get_point(idx, 0, use_global_id)), glm::normalize(get_point(idx, 1, use_global_id) - get_point(idx, 0, use_global_id))) > 0.0f;
+    }
+
+    float TunnelBezierPoints::get_segment_progress(uint32_t segment_id, const glm::vec3& pos, bool use_global_id)
+    {
+        // project pos to the vector and calculate the distance from the start
+        const glm::vec3& start = get_point(segment_id, 0, use_global_id);
+        glm::vec3 line = get_point(segment_id, 2, use_global_id) - start;
+        float len = glm::length(line);
+        line = line / len;
+        return glm::clamp(glm::dot(pos - start, line), 0.0f, len);
+    }
+
+    float TunnelBezierPoints::get_segment_length(uint32_t segment_id, bool use_global_id)
+    {
+        return glm::distance(get_point(segment_id, 0, use_global_id), get_point(segment_id, 2, use_global_id));
+    }
+
+    glm::vec3 TunnelBezierPoints::get_player_reset_position()
+    {
+        return get_point(player_local_segment_position, 0, false);
+    }
+
+    glm::vec3 TunnelBezierPoints::get_player_reset_normal()
+    {
+        // use direction that points somewhat in the direction of the bezier curve
+        glm::vec3& b0 = get_point(player_local_segment_position, 0, false);
+        glm::vec3& b1 = get_point(player_local_segment_position, 1, false);
+        glm::vec3& b2 = get_point(player_local_segment_position, 2, false);
+        return glm::normalize(b1 - b0 + b2 - b0);
+    }
+} // namespace ve
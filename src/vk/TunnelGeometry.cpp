@@ -0,0 +1,315 @@
+#include "vk/TunnelGeometry.hpp"
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+
+#include "vk/TunnelConstants.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define VE_TUNNEL_GEOMETRY_AVX2
+#endif
+
+namespace ve
+{
+    glm::vec3 permute(const glm::vec3& x)
+    {
+        return glm::mod((34.0f * x + 1.0f) * x, 289.0f);
+    }
+
+    float cellular(const glm::vec2& P)
+    {
+        constexpr float K = 0.142857142857f; // 1/7
+        constexpr float Ko = 0.428571428571f; // 3/7
+        constexpr float jitter = 1.0f;
+        const glm::vec2 Pi = glm::mod(glm::floor(P), 289.0f);
+        const glm::vec2 Pf = glm::fract(P);
+        const glm::vec3 oi(-1.0f, 0.0f, 1.0f);
+        const glm::vec3 of(-0.5f, 0.5f, 1.5f);
+        const glm::vec3 px = permute(Pi.x + oi);
+        glm::vec3 p = permute(px.x + Pi.y + oi);
+        glm::vec3 ox = glm::fract(p * K) - Ko;
+        glm::vec3 oy = glm::mod(glm::floor(p * K), 7.0f) * K - Ko;
+        glm::vec3 dx = Pf.x + 0.5f + jitter * ox;
+        glm::vec3 dy = Pf.y - of + jitter * oy;
+        glm::vec3 d1 = dx * dx + dy * dy;
+        p = permute(px.y + Pi.y + oi);
+        ox = glm::fract(p * K) - Ko;
+        oy = glm::mod(glm::floor(p * K), 7.0f) * K - Ko;
+        dx = Pf.x - 0.5f + jitter * ox;
+        dy = Pf.y - of + jitter * oy;
+        glm::vec3 d2 = dx * dx + dy * dy;
+        p = permute(px.z + Pi.y + oi);
+        ox = glm::fract(p * K) - Ko;
+        oy = glm::mod(glm::floor(p * K), 7.0f) * K - Ko;
+        dx = Pf.x - 1.5f + jitter * ox;
+        dy = Pf.y - of + jitter * oy;
+        const glm::vec3 d3 = dx * dx + dy * dy;
+        // sort out the two smallest distances (F1, F2)
+        const glm::vec3 d1a = glm::min(d1, d2);
+        d2 = glm::max(d1, d2);
+        d2 = glm::min(d2, d3);
+        d1 = glm::min(d1a, d2);
+        d2 = glm::max(d1a, d2);
+        if (d1.x >= d1.y) std::swap(d1.x, d1.y);
+        if (d1.x >= d1.z) std::swap(d1.x, d1.z);
+        d1.y = std::min(d1.y, d2.y);
+        d1.z = std::min(d1.z, d2.z);
+        d1.y = std::min(d1.y, d1.z);
+        d1.y = std::min(d1.y, d2.x);
+        return 0.1f + (std::sqrt(d1.y) - std::sqrt(d1.x));
+    }
+
+    glm::vec3 bezier_point(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, float t)
+    {
+        return (1.0f - t) * (1.0f - t) * p0 + (2.0f - 2.0f * t) * t * p1 + t * t * p2;
+    }
+
+    glm::vec3 bezier_derivative(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, float t)
+    {
+        return (2.0f - 2.0f * t) * (p1 - p0) + 2.0f * t * (p2 - p1);
+    }
+
+
+    glm::vec3 get_sample_plane_vector(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& plane_normal)
+    {
+        const glm::vec3 first_dir = glm::normalize(p1 - p0);
+        const glm::vec3 cross_vector = std::abs(glm::dot(first_dir, glm::vec3(1.0f, 0.0f, 0.0f))) >= 0.999999f ? glm::cross(first_dir, glm::normalize(glm::vec3(0.99f, 0.0f, 0.01f))) : glm::cross(first_dir, glm::vec3(1.0f, 0.0f, 0.0f));
+        return glm::cross(plane_normal, cross_vector);
+    }
+
+    // everything of a sample circle that does not depend on the vertex
+    struct SampleCircle
+    {
+        glm::vec3 pos;
+        // rotate(plane_vector, plane_normal, angle) = a * cos + b * sin + c * (1 - cos)
+        glm::vec3 a;
+        glm::vec3 b;
+        glm::vec3 c;
+        float tex_s;
+        float height_weight;
+        // part of the cellular noise that only depends on the x coordinate scaled_tex.s of the noise
+        glm::vec3 noise_px;
+        float noise_pf_x;
+    };
+
+    SampleCircle get_sample_circle(const BezierSegment& segment, uint32_t sample_circle_id)
+    {
+        const float t = float(sample_circle_id) / float(samples_per_segment - 1);
+        const glm::vec3 plane_normal = glm::normalize(bezier_derivative(segment.p0, segment.p1, segment.p2, t));
+        const glm::vec3 plane_vector = get_sample_plane_vector(segment.p0, segment.p1, plane_normal);
+        SampleCircle circle;
+        circle.pos = bezier_point(segment.p0, segment.p1, segment.p2, t);
+        circle.a = plane_vector;
+        circle.b = glm::cross(plane_normal, plane_vector);
+        circle.c = plane_normal * glm::dot(plane_normal, plane_vector);
+        circle.tex_s = std::abs(float(segment.uid % 2) - t);
+        const float scaled_tex_s = circle.tex_s * 2.0f + float(segment.uid);
+        circle.noise_px = permute(glm::mod(std::floor(scaled_tex_s), 289.0f) + glm::vec3(-1.0f, 0.0f, 1.0f));
+        circle.noise_pf_x = scaled_tex_s - std::floor(scaled_tex_s);
+        const float h = (float(sample_circle_id) * 2.0f) / float(samples_per_segment - 1) - 1.0f;
+        circle.height_weight = -(h * h) + 1.0f;
+        return circle;
+    }
+
+    // the angle of a vertex only depends on its id in the circle
+    struct VertexAngles
+    {
+        VertexAngles()
+        {
+            for (uint32_t i = 0; i < vertices_per_sample; ++i)
+            {
+                const float angle = glm::radians((360.0f / vertices_per_sample) * i);
+                cos_theta[i] = std::cos(angle);
+                sin_theta[i] = std::sin(angle);
+                tex_t[i] = std::abs((float(i) / float(vertices_per_sample)) * 2.0f - 1.0f);
+            }
+        }
+
+        alignas(32) std::array<float, vertices_per_sample> cos_theta;
+        alignas(32) std::array<float, vertices_per_sample> sin_theta;
+        alignas(32) std::array<float, vertices_per_sample> tex_t;
+    };
+
+    const VertexAngles& get_vertex_angles()
+    {
+        static const VertexAngles vertex_angles;
+        return vertex_angles;
+    }
+
+    void write_vertex(TunnelVertex& vertex, const glm::vec3& pos, const glm::vec2& tex, uint32_t segment_uid)
+    {
+        vertex.pos = pos;
+        vertex.normal = glm::vec2(0.0f);
+        vertex.tex = tex;
+        vertex.segment_uid = std::bit_cast<uint32_t>(float(segment_uid));
+    }
+
+    void generate_tunnel_segment_scalar(const BezierSegment& segment, TunnelVertex* vertices)
+    {
+        for (uint32_t idx = 0; idx < samples_per_segment * vertices_per_sample; ++idx)
+        {
+            const uint32_t sample_circle_id = idx / vertices_per_sample;
+            const uint32_t vertex_id = idx % vertices_per_sample;
+            const float t = float(sample_circle_id) / float(samples_per_segment - 1);
+            const glm::vec3 sample_pos = bezier_point(segment.p0, segment.p1, segment.p2, t);
+            const glm::vec3 plane_normal = glm::normalize(bezier_derivative(segment.p0, segment.p1, segment.p2, t));
+            const glm::vec3 plane_vector = get_sample_plane_vector(segment.p0, segment.p1, plane_normal);
+            // rotate() of utils.glsl
+            const float angle = glm::radians((360.0f / vertices_per_sample) * vertex_id);
+            const glm::vec3 rotated = plane_vector * std::cos(angle) + glm::cross(plane_normal, plane_vector) * std::sin(angle) + plane_normal * glm::dot(plane_normal, plane_vector) * (1.0f - std::cos(angle));
+            glm::vec3 vertex_pos = glm::normalize(rotated);
+            const glm::vec2 tex(std::abs(float(segment.uid % 2) - t), std::abs((float(vertex_id) / float(vertices_per_sample)) * 2.0f - 1.0f));
+            const glm::vec2 scaled_tex(tex.s * 2.0f + float(segment.uid), tex.t * 3.0f);
+            const float h = (float(sample_circle_id) * 2.0f) / float(samples_per_segment - 1) - 1.0f;
+            const float height = cellular(scaled_tex) * (-(h * h) + 1.0f);
+            vertex_pos *= 20.0f - height * 12.0f;
+            write_vertex(vertices[idx], vertex_pos + sample_pos, tex, segment.uid);
+        }
+    }
+
+    void generate_tunnel_segment_circles(const BezierSegment& segment, TunnelVertex* vertices)
+    {
+        const VertexAngles& angles = get_vertex_angles();
+        for (uint32_t i = 0; i < samples_per_segment; ++i)
+        {
+            const SampleCircle circle = get_sample_circle(segment, i);
+            for (uint32_t j = 0; j < vertices_per_sample; ++j)
+            {
+                const glm::vec3 rotated = circle.a * angles.cos_theta[j] + circle.b * angles.sin_theta[j] + circle.c * (1.0f - angles.cos_theta[j]);
+                const float height = cellular(glm::vec2(circle.tex_s * 2.0f + float(segment.uid), angles.tex_t[j] * 3.0f)) * circle.height_weight;
+                write_vertex(vertices[i * vertices_per_sample + j], glm::normalize(rotated) * (20.0f - height * 12.0f) + circle.pos, glm::vec2(circle.tex_s, angles.tex_t[j]), segment.uid);
+            }
+        }
+    }
+
+#if defined(VE_TUNNEL_GEOMETRY_AVX2)
+    // glsl mod: x - y * floor(x / y) for non negative integer valued x
+    // multiplies with the reciprocal instead of dividing and corrects the result if the rounded quotient was off by one
+    __attribute__((target("avx2,fma"))) inline __m256 mod_avx2(__m256 x, float y)
+    {
+        const __m256 y_v = _mm256_set1_ps(y);
+        const __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(y_v, _mm256_floor_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.0f / y)))));
+        return _mm256_sub_ps(r, _mm256_and_ps(_mm256_cmp_ps(r, y_v, _CMP_GE_OQ), y_v));
+    }
+
+    __attribute__((target("avx2,fma"))) inline __m256 permute_avx2(__m256 x)
+    {
+        return mod_avx2(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(34.0f), x), _mm256_set1_ps(1.0f)), x), 289.0f);
+    }
+
+    // cellular noise of 8 points that share the x coordinate of the sample circle
+    __attribute__((target("avx2,fma"))) __m256 cellular_avx2(const SampleCircle& circle, __m256 P_y)
+    {
+        constexpr float K = 0.142857142857f; // 1/7
+        constexpr float Ko = 0.428571428571f; // 3/7
+        constexpr std::array<float, 3> oi{-1.0f, 0.0f, 1.0f};
+        constexpr std::array<float, 3> of{-0.5f, 0.5f, 1.5f};
+        constexpr std::array<float, 3> dx_offset{0.5f, -0.5f, -1.5f};
+        const __m256 floor_y = _mm256_floor_ps(P_y);
+        const __m256 Pi_y = mod_avx2(floor_y, 289.0f);
+        const __m256 Pf_y = _mm256_sub_ps(P_y, floor_y);
+        const __m256 K_v = _mm256_set1_ps(K);
+        const __m256 Ko_v = _mm256_set1_ps(Ko);
+        // d[row][column] are the squared distances to the 3x3 feature points
+        __m256 d[3][3];
+        for (uint32_t r = 0; r < 3; ++r)
+        {
+            const __m256 row = _mm256_add_ps(_mm256_set1_ps(circle.noise_px[r]), Pi_y);
+            const __m256 dx_base = _mm256_set1_ps(circle.noise_pf_x + dx_offset[r]);
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                const __m256 p = permute_avx2(_mm256_add_ps(row, _mm256_set1_ps(oi[c])));
+                const __m256 pK = _mm256_mul_ps(p, K_v);
+                const __m256 ox = _mm256_sub_ps(_mm256_sub_ps(pK, _mm256_floor_ps(pK)), Ko_v);
+                const __m256 oy = _mm256_sub_ps(_mm256_mul_ps(mod_avx2(_mm256_floor_ps(pK), 7.0f), K_v), Ko_v);
+                const __m256 dx = _mm256_add_ps(dx_base, ox);
+                const __m256 dy = _mm256_add_ps(_mm256_sub_ps(Pf_y, _mm256_set1_ps(of[c])), oy);
+                d[r][c] = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            }
+        }
+        // sort out the two smallest distances (F1, F2) with the same network as the shader
+        __m256 d1[3];
+        __m256 d2[3];
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            const __m256 d1a = _mm256_min_ps(d[0][c], d[1][c]);
+            d2[c] = _mm256_min_ps(_mm256_max_ps(d[0][c], d[1][c]), d[2][c]);
+            d1[c] = _mm256_min_ps(d1a, d2[c]);
+            d2[c] = _mm256_max_ps(d1a, d2[c]);
+        }
+        __m256 swap = _mm256_cmp_ps(d1[0], d1[1], _CMP_LT_OQ);
+        __m256 x = _mm256_blendv_ps(d1[1], d1[0], swap);
+        d1[1] = _mm256_blendv_ps(d1[0], d1[1], swap);
+        d1[0] = x;
+        swap = _mm256_cmp_ps(d1[0], d1[2], _CMP_LT_OQ);
+        x = _mm256_blendv_ps(d1[2], d1[0], swap);
+        d1[2] = _mm256_blendv_ps(d1[0], d1[2], swap);
+        d1[0] = x;
+        d1[1] = _mm256_min_ps(d1[1], d2[1]);
+        d1[2] = _mm256_min_ps(d1[2], d2[2]);
+        d1[1] = _mm256_min_ps(_mm256_min_ps(d1[1], d1[2]), d2[0]);
+        return _mm256_add_ps(_mm256_set1_ps(0.1f), _mm256_sub_ps(_mm256_sqrt_ps(d1[1]), _mm256_sqrt_ps(d1[0])));
+    }
+
+    // the vertices of a sample circle are processed in lanes of 8
+    __attribute__((target("avx2,fma"))) void generate_tunnel_segment_lanes(const BezierSegment& segment, TunnelVertex* vertices)
+    {
+        static_assert(vertices_per_sample % 8 == 0);
+        const VertexAngles& angles = get_vertex_angles();
+        for (uint32_t i = 0; i < samples_per_segment; ++i)
+        {
+            const SampleCircle circle = get_sample_circle(segment, i);
+            const __m256 one = _mm256_set1_ps(1.0f);
+            for (uint32_t j = 0; j < vertices_per_sample; j += 8)
+            {
+                const __m256 cos_theta = _mm256_load_ps(angles.cos_theta.data() + j);
+                const __m256 sin_theta = _mm256_load_ps(angles.sin_theta.data() + j);
+                const __m256 tex_t = _mm256_load_ps(angles.tex_t.data() + j);
+                const __m256 one_minus_cos = _mm256_sub_ps(one, cos_theta);
+                __m256 rotated[3];
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    rotated[k] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(circle.a[k]), cos_theta), _mm256_mul_ps(_mm256_set1_ps(circle.b[k]), sin_theta)), _mm256_mul_ps(_mm256_set1_ps(circle.c[k]), one_minus_cos));
+                }
+                const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rotated[0], rotated[0]), _mm256_mul_ps(rotated[1], rotated[1])), _mm256_mul_ps(rotated[2], rotated[2])));
+                const __m256 height = _mm256_mul_ps(cellular_avx2(circle, _mm256_mul_ps(tex_t, _mm256_set1_ps(3.0f))), _mm256_set1_ps(circle.height_weight));
+                const __m256 radius = _mm256_div_ps(_mm256_sub_ps(_mm256_set1_ps(20.0f), _mm256_mul_ps(height, _mm256_set1_ps(12.0f))), length);
+                // transpose into the interleaved vertex layout
+                alignas(32) float pos[3][8];
+                for (uint32_t k = 0; k < 3; ++k) _mm256_store_ps(pos[k], _mm256_add_ps(_mm256_mul_ps(rotated[k], radius), _mm256_set1_ps(circle.pos[k])));
+                alignas(32) float tex_t_lanes[8];
+                _mm256_store_ps(tex_t_lanes, tex_t);
+                TunnelVertex* out = vertices + i * vertices_per_sample + j;
+                for (uint32_t l = 0; l < 8; ++l)
+                {
+                    const __m256 v = _mm256_setr_ps(pos[0][l], pos[1][l], pos[2][l], 0.0f, 0.0f, circle.tex_s, tex_t_lanes[l], float(segment.uid));
+                    _mm256_storeu_ps(reinterpret_cast<float*>(out + l), v);
+                }
+            }
+        }
+    }
+#endif
+
+    bool generate_tunnel_segment_avx2(const BezierSegment& segment, TunnelVertex* vertices)
+    {
+#if defined(VE_TUNNEL_GEOMETRY_AVX2)
+        static_assert(sizeof(TunnelVertex) == 8 * sizeof(float));
+        static const bool avx2_supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        if (!avx2_supported) return false;
+        generate_tunnel_segment_lanes(segment, vertices);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void generate_tunnel_segment(const BezierSegment& segment, TunnelVertex* vertices)
+    {
+        if (!generate_tunnel_segment_avx2(segment, vertices)) generate_tunnel_segment_circles(segment, vertices);
+    }
+} // namespace ve
@@ -5,7 +5,7 @@
 
 namespace ve
 {
-    TunnelObjects::TunnelObjects(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage) : vmc(vmc), vcc(vcc), storage(storage), fireflies(vmc, vcc, storage), tunnel(vmc, vcc, storage), compute_dsh(vmc), compute_pipeline(vmc), compute_normals_pipeline(vmc), tunnel_bezier_points(segment_count * 2 + 1), rnd(0), dis(0.0f, 1.0f)
+    TunnelObjects::TunnelObjects(const VulkanMainContext& vmc, VulkanCommandContext& vcc, Storage& storage, UploadArena& upload_arena) : vmc(vmc), vcc(vcc), storage(storage), fireflies(vmc, vcc, storage, upload_arena), tunnel(vmc, vcc, storage, upload_arena), compute_dsh(vmc), compute_pipeline(vmc), compute_normals_pipeline(vmc), tunnel_bezier_points(0)
     {}
 
     void TunnelObjects::self_destruct(bool full)
@@ -21,39 +21,27 @@ namespace ve
         }
     }
 
-    void TunnelObjects::init_tunnel(vk::CommandBuffer& cb, PathTracer& path_tracer)
+    void TunnelObjects::init_tunnel(vk::CommandBuffer& cb, PathTracer& path_tracer, uint32_t seed)
     {
-        tunnel_bezier_points_queue = std::queue<glm::vec3>();
-        cpc.segment_uid = 0;
+        tunnel_bezier_points.reset(seed);
         cpc.indices_start_idx = 0;
-        cpc.p0 = glm::vec3(0.0f, 0.0f, segment_scale * player_local_segment_position + 1.0f);
-        cpc.p1 = cpc.p0 - glm::vec3(0.0f, 0.0f, segment_scale / 2.0f);
-        cpc.p2 = cpc.p0 - glm::vec3(0.0f, 0.0f, segment_scale);
-        for (uint32_t i = 1; i < player_local_segment_position; ++i) tunnel_bezier_points_queue.push(glm::vec3(cpc.p0 - glm::vec3(0.0f, 0.0f, segment_scale * (i + 1))));
-        tunnel_bezier_points[0] = cpc.p0;
-        tunnel_bezier_points[1] = cpc.p1;
-        tunnel_bezier_points[2] = cpc.p2;
-        storage.get_buffer(tunnel_bezier_points_buffer).update_data_bytes(tunnel_bezier_points.data(), 16);
+        set_newest_segment_push_constants();
+        storage.get_buffer(tunnel_bezier_points_buffer).update_data_bytes(tunnel_bezier_points.get_points().data(), 16);
         // set current_frame to 1 that fireflies are initially in buffer 1 as this is used as the in_buffer by the first frame
         compute_new_segment(cb, 1);
 
         for (uint32_t i = 1; i < segment_count; ++i)
         {
-            cpc.segment_uid++;
+            tunnel_bezier_points.add_segment();
             cpc.indices_start_idx = i * indices_per_segment;
-            const glm::vec3 normal = glm::normalize(cpc.p2 - cpc.p1);
-            cpc.p1 = cpc.p2 + cpc.p2 - cpc.p1;
-            cpc.p0 = cpc.p2;
-            cpc.p2 = pop_tunnel_bezier_point_queue();
-            tunnel_bezier_points[i * 2 + 1] = cpc.p1;
-            tunnel_bezier_points[i * 2 + 2] = cpc.p2;
+            set_newest_segment_push_constants();
             compute_new_segment(cb, 1);
         }
     }
 
     void TunnelObjects::create_buffers(PathTracer& path_tracer)
     {
-        tunnel_bezier_points_buffer = storage.add_named_buffer(std::string("tunnel_bezier_points"), (tunnel_bezier_points.size() + 2) * 16, vk::BufferUsageFlagBits::eStorageBuffer, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.compute);
+        tunnel_bezier_points_buffer = storage.add_named_buffer(std::string("tunnel_bezier_points"), (tunnel_bezier_points.get_points().size() + 2) * 16, vk::BufferUsageFlagBits::eStorageBuffer, true, vmc.queue_family_indices.transfer, vmc.queue_family_indices.compute);
         tunnel.create_buffers();
         fireflies.create_buffers();
 
@@ -61,6 +49,8 @@ namespace ve
         compute_dsh.add_binding(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(2, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
         compute_dsh.add_binding(3, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
+        compute_dsh.add_binding(4, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
+        compute_dsh.add_binding(5, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute);
 
         for (uint32_t i = 0; i < frames_in_flight; ++i)
         {
@@ -69,57 +59,84 @@ namespace ve
             compute_dsh.add_descriptor(1, storage.get_buffer(tunnel.vertex_buffer));
             compute_dsh.add_descriptor(2, storage.get_buffer(fireflies.vertex_buffers[i]));
             compute_dsh.add_descriptor(3, storage.get_buffer(tunnel_bezier_points_buffer));
+            compute_dsh.add_descriptor(4, storage.get_buffer(tunnel.ring_radii_buffer));
+            compute_dsh.add_descriptor(5, storage.get_buffer(tunnel.collision_vertex_buffer));
         }
         compute_dsh.construct();
-        construct_pipelines();
+        // the tunnel is generated right away, so the compute pipelines cannot wait for the other pipelines of the scene
+        PipelineBuilder pipeline_builder;
+        construct_pipelines(pipeline_builder);
+        pipeline_builder.build();
 
         vk::CommandBuffer& cb = vcc.begin(vcc.compute_cb[0]);
-        init_tunnel(cb, path_tracer);
-        //for (uint32_t i = 0; i < segment_count; ++i)
+        init_tunnel(cb, path_tracer, 0);
+        // ring of one blas per segment, the blas of segment uid is in slot uid % segment_count
+        // the initial segments are written to the start of the buffer, so slot i covers the indices of segment i
+        collision_mesh_barrier(cb);
+        for (uint32_t i = 0; i < segment_count; ++i)
         {
-            blas_indices.push_back(path_tracer.add_blas(cb, tunnel.vertex_buffer, tunnel.index_buffer, std::vector<uint32_t>{0}, std::vector<uint32_t>{index_count}, sizeof(TunnelVertex)));
+            blas_indices.push_back(path_tracer.add_blas(cb, tunnel.collision_vertex_buffer, tunnel.collision_index_buffer, std::vector<uint32_t>{i * collision_indices_per_segment}, std::vector<uint32_t>{collision_indices_per_segment}, sizeof(glm::vec4)));
             instance_indices.push_back(path_tracer.add_instance(blas_indices.back(), glm::mat4(1.0f), 666, 0xFF));
         }
         vcc.submit_compute(cb, true);
     }
 
-    void TunnelObjects::construct(const RenderPass& render_pass)
+    void TunnelObjects::construct(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
-        fireflies.construct(render_pass);
-        tunnel.construct(render_pass);
+        fireflies.construct(render_pass, pipeline_builder);
+        tunnel.construct(render_pass, pipeline_builder);
     }
 
-    void TunnelObjects::construct_pipelines()
+    void TunnelObjects::construct_pipelines(PipelineBuilder& pipeline_builder)
     {
-        std::array<vk::SpecializationMapEntry, 4> compute_entries;
+        std::array<vk::SpecializationMapEntry, 6> compute_entries;
         compute_entries[0] = vk::SpecializationMapEntry(0, 0, sizeof(uint32_t));
         compute_entries[1] = vk::SpecializationMapEntry(1, sizeof(uint32_t), sizeof(uint32_t));
         compute_entries[2] = vk::SpecializationMapEntry(2, sizeof(uint32_t) * 2, sizeof(uint32_t));
         compute_entries[3] = vk::SpecializationMapEntry(3, sizeof(uint32_t) * 3, sizeof(uint32_t));
-        std::array<uint32_t, 4> compute_entries_data{segment_count, samples_per_segment, vertices_per_sample, fireflies_per_segment};
+        compute_entries[4] = vk::SpecializationMapEntry(4, sizeof(uint32_t) * 4, sizeof(uint32_t));
+        compute_entries[5] = vk::SpecializationMapEntry(5, sizeof(uint32_t) * 5, sizeof(uint32_t));
+        std::array<uint32_t, 6> compute_entries_data{segment_count, samples_per_segment, vertices_per_sample, fireflies_per_segment, collision_ring_stride, collision_vertex_stride};
         vk::SpecializationInfo compute_spec_info(compute_entries.size(), compute_entries.data(), compute_entries_data.size() * sizeof(uint32_t), compute_entries_data.data());
 
-        compute_pipeline.construct(compute_dsh.get_layouts()[0], ShaderInfo{"tunnel.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, sizeof(NewSegmentPushConstants));
-        compute_normals_pipeline.construct(compute_dsh.get_layouts()[0], ShaderInfo{"tunnel_normals.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, sizeof(NewSegmentPushConstants));
+        compute_pipeline.describe(compute_dsh.get_layouts()[0], ShaderInfo{"tunnel.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, sizeof(NewSegmentPushConstants));
+
+        pipeline_builder.add(compute_pipeline);
+        compute_normals_pipeline.describe(compute_dsh.get_layouts()[0], ShaderInfo{"tunnel_normals.comp", vk::ShaderStageFlagBits::eCompute, compute_spec_info}, sizeof(NewSegmentPushConstants));
+        pipeline_builder.add(compute_normals_pipeline);
     }
 
-    void TunnelObjects::restart(PathTracer& path_tracer)
+    void TunnelObjects::restart(PathTracer& path_tracer, uint32_t seed)
     {
         vk::CommandBuffer& cb = vcc.begin(vcc.compute_cb[0]);
-        init_tunnel(cb, path_tracer);
-        vk::BufferMemoryBarrier tunnel_buffer_memory_barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eMemoryRead, vmc.queue_family_indices.compute, vmc.queue_family_indices.compute, storage.get_buffer(tunnel.vertex_buffer).get(), 0, storage.get_buffer(tunnel.vertex_buffer).get_byte_size());
-        cb.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, vk::DependencyFlagBits::eDeviceGroup, {}, {tunnel_buffer_memory_barrier}, {});
-        path_tracer.update_blas(tunnel.vertex_buffer, tunnel.index_buffer, std::vector<uint32_t>{0}, std::vector<uint32_t>{index_count}, blas_indices[0], sizeof(TunnelVertex));
+        init_tunnel(cb, path_tracer, seed);
+        collision_mesh_barrier(cb);
+        for (uint32_t i = 0; i < segment_count; ++i) update_segment_blas(path_tracer, i, i * indices_per_segment);
         vcc.submit_compute(cb, true);
     }
 
-    void TunnelObjects::reload_shaders(const RenderPass& render_pass)
+    void TunnelObjects::update_segment_blas(PathTracer& path_tracer, uint32_t segment_uid, uint32_t indices_start_idx)
+    {
+        // the data at indices_start_idx is only overwritten segment_count + 1 segments later, so the blas can be rebuilt lazily by both frames
+        // the blas is built from the coarse collision mesh, which has the same segment slots as the render mesh
+        const uint32_t collision_indices_start_idx = (indices_start_idx / indices_per_segment) * collision_indices_per_segment;
+        path_tracer.update_blas(tunnel.collision_vertex_buffer, tunnel.collision_index_buffer, std::vector<uint32_t>{collision_indices_start_idx}, std::vector<uint32_t>{collision_indices_per_segment}, blas_indices[segment_uid % segment_count], sizeof(glm::vec4));
+    }
+
+    void TunnelObjects::collision_mesh_barrier(vk::CommandBuffer& cb)
+    {
+        Buffer& buffer = storage.get_buffer(tunnel.collision_vertex_buffer);
+        vk::BufferMemoryBarrier collision_buffer_memory_barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eMemoryRead, vmc.queue_family_indices.compute, vmc.queue_family_indices.compute, buffer.get(), 0, buffer.get_byte_size());
+        cb.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, vk::DependencyFlagBits::eDeviceGroup, {}, {collision_buffer_memory_barrier}, {});
+    }
+
+    void TunnelObjects::reload_shaders(const RenderPass& render_pass, PipelineBuilder& pipeline_builder)
     {
-        fireflies.reload_shaders(render_pass);
-        tunnel.reload_shaders(render_pass);
+        fireflies.reload_shaders(render_pass, pipeline_builder);
+        tunnel.reload_shaders(render_pass, pipeline_builder);
 
         self_destruct(false);
-        construct_pipelines();
+        construct_pipelines(pipeline_builder);
     }
 
     void TunnelObjects::draw(vk::CommandBuffer& cb, GameState& gs)
@@ -130,6 +147,13 @@ namespace ve
 
     void TunnelObjects::compute_new_segment(vk::CommandBuffer& cb, uint32_t current_frame)
     {
+        // reset the minimum radii of the rings of the segment to FLT_MAX, tunnel.comp lowers them with atomicMin
+        Buffer& ring_radii_buffer = storage.get_buffer(tunnel.ring_radii_buffer);
+        const vk::DeviceSize ring_radii_offset = (cpc.indices_start_idx / indices_per_segment) * collision_samples_per_segment * sizeof(float);
+        cb.fillBuffer(ring_radii_buffer.get(), ring_radii_offset, collision_samples_per_segment * sizeof(float), 0x7F7FFFFF);
+        vk::BufferMemoryBarrier ring_radii_memory_barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite, vmc.queue_family_indices.compute, vmc.queue_family_indices.compute, ring_radii_buffer.get(), ring_radii_offset, collision_samples_per_segment * sizeof(float));
+        cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlagBits::eDeviceGroup, {}, {ring_radii_memory_barrier}, {});
+
         cb.bindDescriptorSets(vk::PipelineBindPoint::eCompute, compute_pipeline.get_layout(), 0, compute_dsh.get_sets()[current_frame], {});
         cb.pushConstants(compute_pipeline.get_layout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(NewSegmentPushConstants), &cpc);
         cb.bindPipeline(vk::PipelineBindPoint::eCompute, compute_pipeline.get());
@@ -143,84 +167,33 @@ namespace ve
         cb.dispatch(((vertices_per_sample * samples_per_segment + 31) / 32), 1, 1);
     }
 
-    glm::vec3 TunnelObjects::random_cosine(const glm::vec3& normal, const float cosine_weight)
+    void TunnelObjects::set_newest_segment_push_constants()
     {
-        float theta = std::acos(std::pow(1.0f - std::abs(dis(rnd)), 1.0f / (1.0f + cosine_weight)));
-        float phi = 2.0f * M_PIf * dis(rnd);
-        glm::vec3 up = abs(normal.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
-        glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
-        glm::vec3 bitangent = glm::cross(normal, tangent);
-
-        glm::vec3 sample = glm::vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
-        return glm::normalize(tangent * sample.x + bitangent * sample.y + normal * sample.z);
-    }
-
-    glm::vec3 TunnelObjects::pop_tunnel_bezier_point_queue()
-    {
-        // no more Bézier points left, create either a long curve or a small segment
-        if (tunnel_bezier_points_queue.empty())
-        {
-            // high probability for small segment leads to areas with small curvy segments and single long curves
-            const uint32_t random_weight = dis(rnd) < 0.98f ? 1 : 16;
-            glm::vec3 p2 = cpc.p0 + segment_scale * random_weight * random_cosine(glm::normalize(cpc.p1 - cpc.p0), -2.0f * random_weight + 42.0);
-            glm::vec3 p1 = cpc.p0 + (cpc.p1 - cpc.p0) * float(random_weight);
-            for (uint32_t i = 0; i < random_weight; ++i)
-            {
-                const float t = float(i + 1) / float(random_weight);
-                tunnel_bezier_points_queue.push(std::pow(1 - t, 2.0f) * cpc.p0 + (2 - 2 * t) * t * p1 + std::pow(t, 2.0f) * p2);
-            }
-        }
-        glm::vec3 p = tunnel_bezier_points_queue.front();
-        tunnel_bezier_points_queue.pop();
-        return p;
-    }
-
-    glm::vec3& TunnelObjects::get_tunnel_bezier_point(uint32_t segment_id, uint32_t bezier_point_idx, bool use_global_id)
-    {
-        // convert local id to global such that the modulo operator yields the correct idx
-        if (!use_global_id) segment_id = (segment_id + cpc.segment_uid - segment_count + 1);
-        return tunnel_bezier_points[(segment_id * 2 + bezier_point_idx) % tunnel_bezier_points.size()];
-    }
-
-    // project p to the vector and calculate the distance from the start
-    float progress_on_vector(const glm::vec3& start, const glm::vec3& end, const glm::vec3& p)
-    {
-        glm::vec3 line = (end - start);
-        float len = glm::length(line);
-        line = line / len;
-
-        glm::vec3 v = p - start;
-        float d = glm::dot(v, line);
-        d = glm::clamp(d, 0.0f, len);
-        return d;
+        const BezierSegment& segment = tunnel_bezier_points.get_newest_segment();
+        cpc.p0 = segment.p0;
+        cpc.p1 = segment.p1;
+        cpc.p2 = segment.p2;
+        cpc.segment_uid = segment.uid;
     }
 
     void TunnelObjects::advance(GameState& gs, DeviceTimer& timer, PathTracer& path_tracer)
     {
         vk::CommandBuffer& cb = vcc.begin(vcc.compute_cb[gs.game_data.current_frame]);
         fireflies.move_step(cb, gs.game_data.current_frame, timer, cpc.segment_uid);
-        gs.game_data.segment_distance_travelled = progress_on_vector(get_tunnel_bezier_point(gs.game_data.player_data.segment_id, 0, true), get_tunnel_bezier_point(gs.game_data.player_data.segment_id, 2, true), gs.game_data.player_data.pos);
+        gs.game_data.segment_distance_travelled = tunnel_bezier_points.get_segment_progress(gs.game_data.player_data.segment_id, gs.game_data.player_data.pos, true);
         if (cpc.segment_uid - segment_count + 1 + player_local_segment_position < gs.game_data.player_data.segment_id)
         {
             // player passed a segment, add distance of passed segment
-            glm::vec3& bp0 = get_tunnel_bezier_point(gs.game_data.player_data.segment_id - 1, 0, true);
-            glm::vec3& bp1 = get_tunnel_bezier_point(gs.game_data.player_data.segment_id - 1, 1, true);
-            glm::vec3& bp2 = get_tunnel_bezier_point(gs.game_data.player_data.segment_id - 1, 2, true);
-            gs.game_data.tunnel_distance_travelled += glm::distance(bp0, bp2);
+            gs.game_data.tunnel_distance_travelled += tunnel_bezier_points.get_segment_length(gs.game_data.player_data.segment_id - 1, true);
             gs.game_data.segment_distance_travelled = 0.0f;
             // increment the idx at which the compute shader starts to compute new vertices for the corresponding indices by the number of indices in one segment
             // increment the idx at which the rendering starts by the same amount
-            cpc.segment_uid++;
             cpc.indices_start_idx += indices_per_segment;
             gs.game_data.first_segment_indices_idx += indices_per_segment;
 
             // add new segment points
-            const glm::vec3 normal = glm::normalize(cpc.p2 - cpc.p1);
-            cpc.p1 = cpc.p2 + cpc.p2 - cpc.p1;
-            cpc.p0 = cpc.p2;
-            cpc.p2 = pop_tunnel_bezier_point_queue();
-            tunnel_bezier_points[(cpc.segment_uid * 2 + 1) % tunnel_bezier_points.size()] = cpc.p1;
-            tunnel_bezier_points[(cpc.segment_uid * 2 + 2) % tunnel_bezier_points.size()] = cpc.p2;
+            tunnel_bezier_points.add_segment();
+            set_newest_segment_push_constants();
             // reset indices; compute shader inserts data at the last segment of the region that will be rendered now
             // indices need to be resetted if compute shader would write outside of the buffer or if the render region goes beyond the buffer
             // these 2 conditions are always met at the same time (as compute shader writes last rendered segment)
@@ -232,7 +205,7 @@ namespace ve
 
             timer.reset(cb, {DeviceTimer::COMPUTE_TUNNEL_ADVANCE});
             timer.start(cb, DeviceTimer::COMPUTE_TUNNEL_ADVANCE, vk::PipelineStageFlagBits::eAllCommands);
-            Buffer& buffer = storage.get_buffer_by_name("firefly_vertices_" + std::to_string(gs.game_data.current_frame));
+            Buffer& buffer = storage.get_buffer(fireflies.vertex_buffers[gs.game_data.current_frame]);
             vk::BufferMemoryBarrier firefly_buffer_memory_barrier(vk::AccessFlagBits::eMemoryWrite, vk::AccessFlagBits::eMemoryWrite, vmc.queue_family_indices.compute, vmc.queue_family_indices.compute, buffer.get(), 0, buffer.get_byte_size());
             cb.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlagBits::eDeviceGroup, {}, {firefly_buffer_memory_barrier}, {});
             compute_new_segment(cb, gs.game_data.current_frame);
@@ -244,9 +217,9 @@ namespace ve
                 cpc.indices_start_idx += (index_count + indices_per_segment);
             }
             timer.stop(cb, DeviceTimer::COMPUTE_TUNNEL_ADVANCE, vk::PipelineStageFlagBits::eAllCommands);
-            vk::BufferMemoryBarrier tunnel_buffer_memory_barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eMemoryRead, vmc.queue_family_indices.compute, vmc.queue_family_indices.compute, storage.get_buffer(tunnel.vertex_buffer).get(), 0, storage.get_buffer(tunnel.vertex_buffer).get_byte_size());
-            cb.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, vk::DependencyFlagBits::eDeviceGroup, {}, {tunnel_buffer_memory_barrier}, {});
-            path_tracer.update_blas(tunnel.vertex_buffer, tunnel.index_buffer, std::vector<uint32_t>{gs.game_data.first_segment_indices_idx}, std::vector<uint32_t>{index_count}, blas_indices[0], sizeof(TunnelVertex));
+            collision_mesh_barrier(cb);
+            // only the blas of the new segment is rebuilt, it replaces the blas of the segment that just left the tunnel
+            update_segment_blas(path_tracer, cpc.segment_uid, cpc.indices_start_idx);
         }
         path_tracer.create_tlas(cb, gs.game_data.current_frame);
         cb.end();
@@ -254,20 +227,21 @@ namespace ve
 
     bool TunnelObjects::is_pos_past_segment(glm::vec3 pos, uint32_t idx, bool use_global_id)
     {
-        return glm::dot(glm::normalize(pos - get_tunnel_bezier_point(idx, 0, use_global_id)), normalize(get_tunnel_bezier_point(idx, 1, use_global_id) - get_tunnel_bezier_point(idx, 0, use_global_id))) > 0.0f;
+        return tunnel_bezier_points.is_pos_past_segment(pos, idx, use_global_id);
+    }
+
+    uint32_t TunnelObjects::get_first_segment_uid() const
+    {
+        return cpc.segment_uid - segment_count + 1;
     }
 
     glm::vec3 TunnelObjects::get_player_reset_position()
     {
-        return get_tunnel_bezier_point(player_local_segment_position, 0, false);
+        return tunnel_bezier_points.get_player_reset_position();
     }
-    
+
     glm::vec3 TunnelObjects::get_player_reset_normal()
     {
-        // use direction that points somewhat in the direction of the bezier curve
-        glm::vec3& b0 = get_tunnel_bezier_point(player_local_segment_position, 0, false);
-        glm::vec3& b1 = get_tunnel_bezier_point(player_local_segment_position, 1, false);
-        glm::vec3& b2 = get_tunnel_bezier_point(player_local_segment_position, 2, false);
-        return glm::normalize(b1 - b0 + b2 - b0);
+        return tunnel_bezier_points.get_player_reset_normal();
     }
 }
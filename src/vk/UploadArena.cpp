@@ -0,0 +1,45 @@
+#include "vk/UploadArena.hpp"
+
+namespace ve
+{
+    UploadArena::UploadArena(const VulkanMainContext& vmc, Storage& storage) : vmc(vmc), storage(storage), frame_byte_size(0)
+    {
+        const vk::PhysicalDeviceLimits limits = vmc.physical_device.get().getProperties().limits;
+        alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+        offsets.fill(0);
+    }
+
+    void UploadArena::create_buffers(vk::DeviceSize frame_byte_size)
+    {
+        this->frame_byte_size = frame_byte_size;
+        for (uint32_t i = 0; i < frames_in_flight; ++i)
+        {
+            buffers[i] = storage.add_named_buffer(std::string("upload_arena_") + std::to_string(i), frame_byte_size, vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer, false, vmc.queue_family_indices.graphics, vmc.queue_family_indices.compute);
+            offsets[i] = 0;
+        }
+    }
+
+    void UploadArena::self_destruct()
+    {
+        for (uint32_t i = 0; i < frames_in_flight; ++i) storage.destroy_buffer(buffers[i]);
+    }
+
+    void UploadArena::begin_frame(uint32_t frame_idx)
+    {
+        offsets[frame_idx] = 0;
+    }
+
+    uint32_t UploadArena::upload_bytes(uint32_t frame_idx, const void* data, std::size_t byte_count)
+    {
+        const vk::DeviceSize offset = offsets[frame_idx];
+        VE_ASSERT(offset + byte_count <= frame_byte_size, "Upload arena of frame {} is full!", frame_idx);
+        storage.get_buffer(buffers[frame_idx]).update_data_bytes(data, byte_count, offset);
+        offsets[frame_idx] = (offset + byte_count + alignment - 1) / alignment * alignment;
+        return offset;
+    }
+
+    const Buffer& UploadArena::get_buffer(uint32_t frame_idx) const
+    {
+        return storage.get_buffer(buffers[frame_idx]);
+    }
+} // namespace ve
@@ -0,0 +1,224 @@
+#include "vk/UploadContext.hpp"
+
+#include "ve_log.hpp"
+
+namespace ve
+{
+    UploadContext::UploadContext(const VulkanMainContext& vmc, vk::DeviceSize staging_byte_size) : vmc(vmc), command_pool(vmc.logical_device.get(), vmc.queue_family_indices.transfer), staging_byte_size(staging_byte_size)
+    {
+        std::vector<vk::CommandBuffer> cbs = command_pool.create_command_buffers(upload_batch_count);
+        std::copy(cbs.begin(), cbs.end(), command_buffers.begin());
+        batch_byte_counts.fill(0);
+
+        vk::SemaphoreTypeCreateInfo stci{};
+        stci.sType = vk::StructureType::eSemaphoreTypeCreateInfo;
+        stci.semaphoreType = vk::SemaphoreType::eTimeline;
+        stci.initialValue = 0;
+        vk::SemaphoreCreateInfo sci{};
+        sci.sType = vk::StructureType::eSemaphoreCreateInfo;
+        sci.pNext = &stci;
+        semaphore = vmc.logical_device.get().createSemaphore(sci);
+
+        vk::BufferCreateInfo bci{};
+        bci.sType = vk::StructureType::eBufferCreateInfo;
+        bci.size = staging_byte_size;
+        bci.usage = vk::BufferUsageFlagBits::eTransferSrc;
+        bci.sharingMode = vk::SharingMode::eExclusive;
+        VmaAllocationCreateInfo vaci{};
+        vaci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+        vaci.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        VkBuffer local_buffer;
+        VmaAllocationInfo vai;
+        VE_CHECK(vk::Result(vmaCreateBuffer(vmc.va, (VkBufferCreateInfo*) (&bci), &vaci, &local_buffer, &staging_vmaa, &vai)), "Failed to create upload staging ring!");
+        staging_buffer = vk::Buffer(local_buffer);
+        staging_mem = static_cast<uint8_t*>(vai.pMappedData);
+    }
+
+    void UploadContext::self_destruct()
+    {
+        wait_idle();
+        vmc.logical_device.get().destroySemaphore(semaphore);
+        vmaDestroyBuffer(vmc.va, staging_buffer, staging_vmaa);
+        command_pool.self_destruct();
+    }
+
+    void UploadContext::upload_buffer(vk::Buffer dst, vk::DeviceSize dst_offset, const void* data, vk::DeviceSize byte_count)
+    {
+        add_write_barrier(get_command_buffer(), dst);
+        // split large uploads that the ring can be refilled while earlier parts are still copied
+        const vk::DeviceSize max_chunk_size = staging_byte_size / upload_batch_count;
+        for (vk::DeviceSize done = 0; done < byte_count;)
+        {
+            const vk::DeviceSize chunk_size = std::min(byte_count - done, max_chunk_size);
+            const vk::DeviceSize offset = allocate(chunk_size);
+            memcpy(staging_mem + offset, static_cast<const uint8_t*>(data) + done, chunk_size);
+            vmaFlushAllocation(vmc.va, staging_vmaa, offset, chunk_size);
+            vk::CommandBuffer& cb = get_command_buffer();
+            cb.copyBuffer(staging_buffer, dst, vk::BufferCopy(offset, dst_offset + done, chunk_size));
+            written_buffers.insert(VkBuffer(dst));
+            done += chunk_size;
+        }
+    }
+
+    void UploadContext::fill_buffer(vk::Buffer dst, vk::DeviceSize dst_offset, vk::DeviceSize byte_count, uint32_t value)
+    {
+        VE_ASSERT(byte_count == VK_WHOLE_SIZE || byte_count % 4 == 0, "Size of buffer fill needs to be a multiple of 4!");
+        vk::CommandBuffer& cb = get_command_buffer();
+        add_write_barrier(cb, dst);
+        cb.fillBuffer(dst, dst_offset, byte_count, value);
+        written_buffers.insert(VkBuffer(dst));
+    }
+
+    void UploadContext::upload_image(vk::Image dst, const unsigned char* data, vk::Extent3D extent, uint32_t layer_count, uint32_t pixel_byte_size, uint32_t mip_levels)
+    {
+        vk::ImageMemoryBarrier imb{};
+        imb.sType = vk::StructureType::eImageMemoryBarrier;
+        imb.oldLayout = vk::ImageLayout::eUndefined;
+        imb.newLayout = vk::ImageLayout::eTransferDstOptimal;
+        imb.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imb.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imb.image = dst;
+        imb.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+        imb.subresourceRange.baseMipLevel = 0;
+        imb.subresourceRange.levelCount = mip_levels;
+        imb.subresourceRange.baseArrayLayer = 0;
+        imb.subresourceRange.layerCount = layer_count;
+        imb.srcAccessMask = {};
+        imb.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+        get_command_buffer().pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, imb);
+
+        // copy whole rows that large images can be split over multiple batches
+        const vk::DeviceSize row_byte_size = extent.width * pixel_byte_size;
+        const vk::DeviceSize layer_byte_size = row_byte_size * extent.height;
+        const uint32_t rows_per_chunk = std::max(vk::DeviceSize(1), (staging_byte_size / upload_batch_count) / row_byte_size);
+        for (uint32_t layer = 0; layer < layer_count; ++layer)
+        {
+            for (uint32_t row = 0; row < extent.height; row += rows_per_chunk)
+            {
+                const uint32_t row_count = std::min(rows_per_chunk, extent.height - row);
+                const vk::DeviceSize chunk_size = row_count * row_byte_size;
+                const vk::DeviceSize offset = allocate(chunk_size);
+                memcpy(staging_mem + offset, data + layer * layer_byte_size + row * row_byte_size, chunk_size);
+                vmaFlushAllocation(vmc.va, staging_vmaa, offset, chunk_size);
+
+                vk::BufferImageCopy copy_region{};
+                copy_region.bufferOffset = offset;
+                copy_region.bufferRowLength = 0;
+                copy_region.bufferImageHeight = 0;
+                copy_region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+                copy_region.imageSubresource.mipLevel = 0;
+                copy_region.imageSubresource.baseArrayLayer = layer;
+                copy_region.imageSubresource.layerCount = 1;
+                copy_region.imageOffset = vk::Offset3D{0, int32_t(row), 0};
+                copy_region.imageExtent = vk::Extent3D{extent.width, row_count, 1};
+                get_command_buffer().copyBufferToImage(staging_buffer, dst, vk::ImageLayout::eTransferDstOptimal, copy_region);
+            }
+        }
+    }
+
+    uint64_t UploadContext::flush()
+    {
+        if (!recording) return batch_value - 1;
+        vk::CommandBuffer& cb = command_buffers[batch_value % upload_batch_count];
+        cb.end();
+        vk::TimelineSemaphoreSubmitInfo tssi{};
+        tssi.sType = vk::StructureType::eTimelineSemaphoreSubmitInfo;
+        tssi.signalSemaphoreValueCount = 1;
+        tssi.pSignalSemaphoreValues = &batch_value;
+        vk::SubmitInfo submit_info{};
+        submit_info.sType = vk::StructureType::eSubmitInfo;
+        submit_info.pNext = &tssi;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &cb;
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores = &semaphore;
+        vmc.get_transfer_queue().submit(submit_info);
+        recording = false;
+        written_buffers.clear();
+        return batch_value++;
+    }
+
+    void UploadContext::wait_idle()
+    {
+        wait(flush());
+    }
+
+    const vk::Semaphore& UploadContext::get_semaphore() const
+    {
+        return semaphore;
+    }
+
+    vk::CommandBuffer& UploadContext::get_command_buffer()
+    {
+        vk::CommandBuffer& cb = command_buffers[batch_value % upload_batch_count];
+        if (!recording)
+        {
+            // the command buffer was last used upload_batch_count batches ago
+            if (batch_value > upload_batch_count) wait(batch_value - upload_batch_count);
+            cb.reset();
+            vk::CommandBufferBeginInfo cbbi{};
+            cbbi.sType = vk::StructureType::eCommandBufferBeginInfo;
+            cbbi.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+            cb.begin(cbbi);
+            // earlier batches on the transfer queue may still write to the same memory
+            vk::MemoryBarrier mb(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferWrite);
+            cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, mb, {}, {});
+            recording = true;
+        }
+        return cb;
+    }
+
+    vk::DeviceSize UploadContext::allocate(vk::DeviceSize byte_count)
+    {
+        // keep every allocation aligned for buffer and image copies
+        byte_count = (byte_count + 15) & ~vk::DeviceSize(15);
+        VE_ASSERT(byte_count <= staging_byte_size, "Upload is larger than the staging ring!");
+        vk::DeviceSize skipped;
+        while (true)
+        {
+            if (used_byte_count == 0) head = 0;
+            // skip the end of the ring if the allocation does not fit in there
+            skipped = head + byte_count > staging_byte_size ? staging_byte_size - head : 0;
+            if (used_byte_count + skipped + byte_count <= staging_byte_size) break;
+            // wait for the oldest submitted batch or submit the recorded batch if there are no others
+            if (released_value + 1 < batch_value) wait(released_value + 1);
+            else flush();
+        }
+        get_command_buffer();
+        const vk::DeviceSize offset = skipped > 0 ? 0 : head;
+        head = offset + byte_count;
+        used_byte_count += skipped + byte_count;
+        batch_byte_counts[batch_value % upload_batch_count] += skipped + byte_count;
+        return offset;
+    }
+
+    void UploadContext::wait(uint64_t value)
+    {
+        if (value <= released_value) return;
+        vk::SemaphoreWaitInfo swi{};
+        swi.sType = vk::StructureType::eSemaphoreWaitInfo;
+        swi.semaphoreCount = 1;
+        swi.pSemaphores = &semaphore;
+        swi.pValues = &value;
+        VE_CHECK(vmc.logical_device.get().waitSemaphores(swi, uint64_t(-1)), "Failed to wait for uploads!");
+        release(value);
+    }
+
+    void UploadContext::release(uint64_t value)
+    {
+        while (released_value < value)
+        {
+            ++released_value;
+            used_byte_count -= batch_byte_counts[released_value % upload_batch_count];
+            batch_byte_counts[released_value % upload_batch_count] = 0;
+        }
+    }
+
+    void UploadContext::add_write_barrier(vk::CommandBuffer& cb, vk::Buffer dst)
+    {
+        if (!written_buffers.contains(VkBuffer(dst))) return;
+        vk::MemoryBarrier mb(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferWrite);
+        cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, mb, {}, {});
+        written_buffers.clear();
+    }
+} // namespace ve
@@ -4,7 +4,7 @@
 
 namespace ve
 {
-        VulkanCommandContext::VulkanCommandContext(VulkanMainContext& vmc) : vmc(vmc)
+        VulkanCommandContext::VulkanCommandContext(VulkanMainContext& vmc) : vmc(vmc), upload_context(vmc, upload_staging_byte_size)
         {
             command_pools.push_back(CommandPool(vmc.logical_device.get(), vmc.queue_family_indices.graphics));
             command_pools.push_back(CommandPool(vmc.logical_device.get(), vmc.queue_family_indices.compute));
@@ -39,33 +39,45 @@ namespace ve
             return cb;
         }
 
-        void VulkanCommandContext::submit_graphics(const vk::CommandBuffer& cb, bool wait_idle) const
+        void VulkanCommandContext::submit_graphics(const vk::CommandBuffer& cb, bool wait_idle)
         {
             submit(cb, vmc.get_graphics_queue(), wait_idle);
         }
 
-        void VulkanCommandContext::submit_compute(const vk::CommandBuffer& cb, bool wait_idle) const
+        void VulkanCommandContext::submit_compute(const vk::CommandBuffer& cb, bool wait_idle)
         {
             submit(cb, vmc.get_compute_queue(), wait_idle);
         }
 
-        void VulkanCommandContext::submit_transfer(const vk::CommandBuffer& cb, bool wait_idle) const
+        void VulkanCommandContext::submit_transfer(const vk::CommandBuffer& cb, bool wait_idle)
         {
             submit(cb, vmc.get_transfer_queue(), wait_idle);
         }
 
         void VulkanCommandContext::self_destruct()
         {
+            upload_context.self_destruct();
             for (auto& command_pool : command_pools) command_pool.self_destruct();
             command_pools.clear();
             spdlog::info("Destroyed VulkanCommandContext");
         }
 
-        void VulkanCommandContext::submit(const vk::CommandBuffer& cb, const vk::Queue& queue, bool wait_idle) const
+        void VulkanCommandContext::submit(const vk::CommandBuffer& cb, const vk::Queue& queue, bool wait_idle)
         {
             cb.end();
+            // submit all uploads that were recorded until now and let the command buffer wait for them
+            const uint64_t upload_value = upload_context.flush();
+            const vk::PipelineStageFlags upload_wait_stage = vk::PipelineStageFlagBits::eAllCommands;
+            vk::TimelineSemaphoreSubmitInfo tssi{};
+            tssi.sType = vk::StructureType::eTimelineSemaphoreSubmitInfo;
+            tssi.waitSemaphoreValueCount = 1;
+            tssi.pWaitSemaphoreValues = &upload_value;
             vk::SubmitInfo submit_info{};
             submit_info.sType = vk::StructureType::eSubmitInfo;
+            submit_info.pNext = &tssi;
+            submit_info.waitSemaphoreCount = 1;
+            submit_info.pWaitSemaphores = &upload_context.get_semaphore();
+            submit_info.pWaitDstStageMask = &upload_wait_stage;
             submit_info.commandBufferCount = 1;
             submit_info.pCommandBuffers = &cb;
             queue.submit(submit_info);
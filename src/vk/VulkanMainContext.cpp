@@ -30,7 +30,7 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debug_callback(VkDebugUtilsMessageSeverity
 namespace ve
 {
     // create VulkanMainContext without window for non graphical applications
-    VulkanMainContext::VulkanMainContext() : instance({}), physical_device(instance, surface), queue_family_indices(physical_device.get_queue_families(surface)), logical_device(physical_device, queue_family_indices, queues)
+    VulkanMainContext::VulkanMainContext() : instance({}), physical_device(instance, surface), queue_family_indices(physical_device.get_queue_families(surface)), logical_device(physical_device, queue_family_indices, queues), pipeline_cache(physical_device, logical_device)
     {
         create_vma_allocator();
         setup_debug_messenger();
@@ -38,7 +38,7 @@ namespace ve
     }
 
     // create VulkanMainContext with window for graphical applications
-    VulkanMainContext::VulkanMainContext(const uint32_t width, const uint32_t height) : window(std::make_optional<Window>(width, height)), instance(window->get_required_extensions()), surface(window->create_surface(instance.get())), physical_device(instance, surface), queue_family_indices(physical_device.get_queue_families(surface)), logical_device(physical_device, queue_family_indices, queues)
+    VulkanMainContext::VulkanMainContext(const uint32_t width, const uint32_t height) : window(std::make_optional<Window>(width, height)), instance(window->get_required_extensions()), surface(window->create_surface(instance.get())), physical_device(instance, surface), queue_family_indices(physical_device.get_queue_families(surface)), logical_device(physical_device, queue_family_indices, queues), pipeline_cache(physical_device, logical_device)
     {
         create_vma_allocator();
         setup_debug_messenger();
@@ -47,7 +47,9 @@ namespace ve
 
     void VulkanMainContext::self_destruct()
     {
+        buffer_pools.self_destruct();
         vmaDestroyAllocator(va);
+        pipeline_cache.self_destruct();
         if (surface.has_value()) instance.get().destroySurfaceKHR(surface.value());
         logical_device.self_destruct();
         auto func = (PFN_vkDestroyDebugUtilsMessengerEXT) instance.get().getProcAddr("vkDestroyDebugUtilsMessengerEXT");
@@ -104,6 +106,7 @@ namespace ve
         vaci.vulkanApiVersion = VK_API_VERSION_1_3;
         vaci.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
         vmaCreateAllocator(&vaci, &va);
+        buffer_pools.construct(va);
     }
 
     void VulkanMainContext::setup_debug_messenger()
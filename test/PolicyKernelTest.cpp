@@ -0,0 +1,76 @@
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <torch/torch.h>
+
+#include "NeuralNet.hpp"
+#include "PolicyKernel.hpp"
+
+// compares the policy kernel with every supported instruction set against NeuralNet::forward
+
+constexpr uint32_t state_count = 7;
+// the last states produce logits far beyond the range of exp, so they only pass with the max subtracted in the softmax
+constexpr uint32_t first_extreme_state = 4;
+const std::array<std::array<float, NeuralNet::input_size>, state_count> states{{
+    {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+    {1.5f, 3.0f, 7.25f, 12.0f, 0.5f, 40.0f, 2.0f, -0.3f},
+    {50.0f, 60.0f, 70.0f, 80.0f, 90.0f, 100.0f, 20.0f, 1.0f},
+    {-20.0f, -5.0f, -1.0f, 0.0f, 1.0f, 5.0f, 20.0f, -1.0f},
+    {1e3f, -1e3f, 5e2f, -5e2f, 2e3f, -2e3f, 1e3f, -1e3f},
+    {1e4f, 1e4f, 1e4f, 1e4f, 1e4f, 1e4f, 1e4f, 1e4f},
+    {-1e4f, 3e3f, -7e3f, 1e4f, -2e3f, 8e3f, -1e4f, 5e3f},
+}};
+// fma and a different summation order change the rounding of large logits
+constexpr float max_difference = 1e-4f;
+constexpr float max_extreme_difference = 1e-3f;
+
+int main()
+{
+    torch::manual_seed(0);
+    NeuralNet nn;
+    nn.eval();
+    PolicyKernel kernel;
+    torch::NoGradGuard no_grad;
+    auto parameters = nn.named_parameters();
+    for (uint32_t i = 0; i < PolicyKernel::layer_count; ++i)
+    {
+        torch::Tensor weight = parameters["fc" + std::to_string(i) + ".weight"].contiguous();
+        torch::Tensor bias = parameters["fc" + std::to_string(i) + ".bias"].contiguous();
+        kernel.set_layer(i, weight.const_data_ptr<float>(), bias.const_data_ptr<float>());
+    }
+    torch::Tensor expected = nn.forward(torch::from_blob(const_cast<float*>(states[0].data()), {int64_t(state_count), int64_t(NeuralNet::input_size)})).contiguous();
+    auto expected_a = expected.accessor<float, 2>();
+
+    bool passed = true;
+    for (PolicyKernel::Isa isa : {PolicyKernel::Isa::Scalar, PolicyKernel::Isa::AVX2, PolicyKernel::Isa::NEON})
+    {
+        if (!kernel.set_isa(isa))
+        {
+            std::cout << "Skipping instruction set " << uint32_t(isa) << " that is not supported" << std::endl;
+            continue;
+        }
+        float max_diff = 0.0f;
+        for (uint32_t i = 0; i < state_count; ++i)
+        {
+            std::array<float, PolicyKernel::output_size> probs;
+            kernel.forward(states[i].data(), probs.data());
+            float sum = 0.0f;
+            float diff = 0.0f;
+            for (uint32_t j = 0; j < probs.size(); ++j)
+            {
+                sum += probs[j];
+                diff = std::max(diff, std::abs(probs[j] - expected_a[i][j]));
+            }
+            const float allowed_diff = i < first_extreme_state ? max_difference : max_extreme_difference;
+            if (!std::isfinite(sum) || std::abs(sum - 1.0f) > max_difference || !(diff <= allowed_diff))
+            {
+                std::cout << kernel.get_isa_name() << ": state " << i << " differs by " << diff << " with probability sum " << sum << std::endl;
+                passed = false;
+            }
+            max_diff = std::max(max_diff, diff);
+        }
+        std::cout << kernel.get_isa_name() << ": max difference to libtorch " << max_diff << std::endl;
+    }
+    return passed ? 0 : 1;
+}
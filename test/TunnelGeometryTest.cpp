@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <glm/geometric.hpp>
+
+#include "vk/TunnelBezierPoints.hpp"
+#include "vk/TunnelConstants.hpp"
+#include "vk/TunnelGeometry.hpp"
+
+// compares the avx2 and the fallback path of generate_tunnel_segment against generate_tunnel_segment_scalar
+
+// the paths only differ in fma and the order of operations, tex and uid are expected to match closely
+constexpr float max_pos_difference = 1e-3f;
+constexpr float max_tex_difference = 1e-4f;
+
+using namespace ve;
+
+std::vector<BezierSegment> get_segments()
+{
+    std::vector<BezierSegment> segments;
+    // straight segment along -z like the first segment after a reset
+    TunnelBezierPoints tunnel_bezier_points(0);
+    segments.push_back(tunnel_bezier_points.get_newest_segment());
+    // curved segments with odd and even uids from different seeds
+    for (uint32_t seed : {1u, 42u})
+    {
+        tunnel_bezier_points.reset(seed);
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            tunnel_bezier_points.add_segment();
+            segments.push_back(tunnel_bezier_points.get_newest_segment());
+        }
+    }
+    // large uid far away from the origin
+    for (uint32_t i = 0; i < 100; ++i) tunnel_bezier_points.add_segment();
+    segments.push_back(tunnel_bezier_points.get_newest_segment());
+    // first direction parallel to the x axis to hit the special case of the sample plane vector
+    segments.push_back(BezierSegment{glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(segment_scale / 2.0f, 0.0f, 0.0f), glm::vec3(segment_scale, 5.0f, -3.0f), 7});
+    return segments;
+}
+
+bool compare(const char* name, const std::vector<TunnelVertex>& vertices, const std::vector<TunnelVertex>& expected, uint32_t segment_idx, float& max_pos_diff, float& max_tex_diff)
+{
+    bool passed = true;
+    for (uint32_t i = 0; i < vertices.size(); ++i)
+    {
+        const float pos_diff = glm::length(vertices[i].pos - expected[i].pos);
+        const float tex_diff = glm::length(vertices[i].tex - expected[i].tex);
+        if (!(pos_diff <= max_pos_difference) || !(tex_diff <= max_tex_difference) || vertices[i].segment_uid != expected[i].segment_uid)
+        {
+            std::cout << name << ": segment " << segment_idx << " vertex " << i << " differs by " << pos_diff << " in pos and " << tex_diff << " in tex" << std::endl;
+            passed = false;
+            break;
+        }
+        max_pos_diff = std::max(max_pos_diff, pos_diff);
+        max_tex_diff = std::max(max_tex_diff, tex_diff);
+    }
+    return passed;
+}
+
+int main()
+{
+    const std::vector<BezierSegment> segments = get_segments();
+    std::vector<TunnelVertex> expected(samples_per_segment * vertices_per_sample);
+    std::vector<TunnelVertex> vertices(samples_per_segment * vertices_per_sample);
+    bool passed = true;
+    bool avx2_supported = true;
+    float max_pos_diff[2] = {0.0f, 0.0f};
+    float max_tex_diff[2] = {0.0f, 0.0f};
+    for (uint32_t i = 0; i < segments.size(); ++i)
+    {
+        generate_tunnel_segment_scalar(segments[i], expected.data());
+        if (avx2_supported)
+        {
+            std::fill(vertices.begin(), vertices.end(), TunnelVertex{});
+            avx2_supported = generate_tunnel_segment_avx2(segments[i], vertices.data());
+            if (avx2_supported) passed &= compare("AVX2", vertices, expected, i, max_pos_diff[0], max_tex_diff[0]);
+        }
+        std::fill(vertices.begin(), vertices.end(), TunnelVertex{});
+        generate_tunnel_segment_circles(segments[i], vertices.data());
+        passed &= compare("Fallback", vertices, expected, i, max_pos_diff[1], max_tex_diff[1]);
+    }
+    if (avx2_supported) std::cout << "AVX2: max difference to reference " << max_pos_diff[0] << " in pos and " << max_tex_diff[0] << " in tex" << std::endl;
+    else std::cout << "Skipping AVX2 that is not supported" << std::endl;
+    std::cout << "Fallback: max difference to reference " << max_pos_diff[1] << " in pos and " << max_tex_diff[1] << " in tex" << std::endl;
+    return passed ? 0 : 1;
+}